@@ -0,0 +1,434 @@
+#include "AgeTableBenchmarks.hpp"
+#include "Benchmark.hpp"
+#include "Zipf.hpp"
+
+#include <non_std/containers/FixedSizeHashTableOpenHashingWithAge.hpp>
+
+#include <algorithm>
+#include <barrier>
+#include <bit>
+#include <cstdio>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <random>
+#include <stdint.h>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace bench::age_table
+{
+
+namespace
+{
+
+constexpr std::size_t Entries = 1u << 22;
+constexpr std::size_t Lookups = 1u << 22;
+
+using RecencyTable = non_std::containers::FixedSizeHashTableOpenHashingWithAge<uint64_t, uint64_t>;
+using GenerationTable = non_std::containers::FixedSizeHashTableOpenHashingWithAge<uint64_t, uint64_t,
+    std::hash<uint64_t>, non_std::containers::AgeByGeneration>;
+
+std::vector<uint64_t> randomKeys(uint64_t seed, std::size_t count)
+{
+    std::vector<uint64_t> keys(count);
+    std::mt19937_64 rng(seed);
+    for (auto& key : keys)
+    {
+        key = rng();
+    }
+    return keys;
+}
+
+// Readers sharing one table: get() writes locks and ages, so it needs the table to itself (a mutex
+// here), while probe() only reads. Wall time per lookup across all threads.
+constexpr std::size_t LookupsPerReader = 1u << 20;
+
+template <typename TLookup>
+void readers(const std::string& name, unsigned threads, const std::vector<uint64_t>& keys, TLookup lookup)
+{
+    std::barrier sync(threads + 1);
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < threads; ++t)
+    {
+        workers.emplace_back([t, &keys, &sync, &lookup]() {
+            uint64_t found = 0;
+            sync.arrive_and_wait();
+            for (std::size_t i = 0; i < LookupsPerReader; ++i)
+            {
+                found += lookup(keys[(i * 7 + t * 101) % keys.size()]);
+            }
+            doNotOptimize(found);
+        });
+    }
+    sync.arrive_and_wait();
+    Stopwatch stopwatch;
+    for (auto& worker : workers)
+    {
+        worker.join();
+    }
+    report(name + " threads=" + std::to_string(threads), stopwatch.elapsedNs() / (LookupsPerReader * threads));
+}
+
+template <typename TTable>
+void readers(TTable& table, const std::vector<uint64_t>& keys, const std::string& name)
+{
+    std::mutex mutex;
+    for (unsigned threads : {1u, 2u, 4u, 8u})
+    {
+        readers("age_table/" + name + " shared get", threads, keys, [&](uint64_t key) {
+            std::lock_guard lock(mutex);
+            return table.get(key) != nullptr;
+        });
+        readers("age_table/" + name + " shared probe", threads, keys, [&](uint64_t key) {
+            return table.probe(key).has_value();
+        });
+    }
+}
+
+template <typename TTable>
+void run(const std::string& name)
+{
+    TTable table(Entries);
+    report("age_table/" + name + " entries per MB", table.capacity() / (table.memoryUsage() / double(1u << 20)), "entries");
+
+    // Filled to capacity, so the last inserts already replace.
+    const auto keys = randomKeys(1, Entries);
+    {
+        Stopwatch stopwatch;
+        for (auto key : keys)
+        {
+            table.store(key, key);
+        }
+        report("age_table/" + name + " store", stopwatch.elapsedNs() / keys.size());
+    }
+
+    std::vector<uint64_t> hits;
+    for (auto key : keys)
+    {
+        if (table.get(key) != nullptr)
+        {
+            hits.push_back(key);
+        }
+    }
+    std::shuffle(hits.begin(), hits.end(), std::mt19937_64(2));
+    hits.resize(std::min(hits.size(), Lookups));
+    reportPercent("age_table/" + name + " kept after filling to capacity", 100.0 * hits.size() / keys.size());
+    const auto misses = randomKeys(3, Lookups);
+
+    for (auto [kind, lookups] : {std::pair{"hit", &std::as_const(hits)}, std::pair{"miss", &misses}})
+    {
+        uint64_t found = 0;
+        Stopwatch stopwatch;
+        for (auto key : *lookups)
+        {
+            found += table.get(key) != nullptr;
+        }
+        doNotOptimize(found);
+        report("age_table/" + name + " get " + kind, stopwatch.elapsedNs() / lookups->size());
+    }
+    for (auto [kind, lookups] : {std::pair{"hit", &std::as_const(hits)}, std::pair{"miss", &misses}})
+    {
+        uint64_t found = 0;
+        Stopwatch stopwatch;
+        for (auto key : *lookups)
+        {
+            found += table.probe(key).has_value();
+        }
+        doNotOptimize(found);
+        report("age_table/" + name + " probe " + kind, stopwatch.elapsedNs() / lookups->size());
+    }
+    {
+        // Each key depends on the value found before, so misses cannot overlap: probe latency.
+        uint64_t previous = 0;
+        Stopwatch stopwatch;
+        for (std::size_t i = 0; i < hits.size(); ++i)
+        {
+            uint64_t* val = table.get(hits[(i + (previous & 1)) % hits.size()]);
+            previous = val != nullptr ? *val : 0;
+        }
+        doNotOptimize(previous);
+        report("age_table/" + name + " get hit dependent", stopwatch.elapsedNs() / hits.size());
+    }
+    readers(table, hits, name);
+}
+
+// 2M-entry table, each lookup's key prefetched distance lookups ahead (0 = no prefetch). Every hit
+// reads its value, so the value line is part of the measured miss.
+void prefetchDistance()
+{
+    RecencyTable table(1u << 21);
+    const auto keys = randomKeys(6, table.capacity());
+    for (auto key : keys)
+    {
+        table.store(key, key);
+    }
+    std::vector<uint64_t> lookups(Lookups);
+    std::mt19937_64 rng(7);
+    for (auto& key : lookups)
+    {
+        key = keys[rng() % keys.size()];
+    }
+
+    for (std::size_t distance : {0u, 1u, 2u, 4u, 8u, 16u, 32u, 64u})
+    {
+        uint64_t found = 0;
+        Stopwatch stopwatch;
+        for (std::size_t i = 0; i < lookups.size(); ++i)
+        {
+            if (distance != 0 && i + distance < lookups.size())
+            {
+                table.prefetch(lookups[i + distance]);
+            }
+            auto hit = table.get(lookups[i]);
+            const uint64_t* value = hit;
+            found += value != nullptr ? *value : 0;
+        }
+        doNotOptimize(found);
+        report("age_table/get prefetch distance=" + std::to_string(distance), stopwatch.elapsedNs() / lookups.size());
+    }
+}
+
+// Trace replay: a search probes the table and stores what it computed on a miss. Keys are Zipf
+// distributed; the depth of a key is fixed and geometric, and a hit saves 2^depth work.
+constexpr std::size_t TraceEntries = 1u << 15;
+constexpr std::size_t TraceUniverse = 1u << 20;
+constexpr std::size_t TraceLength = 1u << 22;
+constexpr std::size_t GenerationLength = 1u << 16;
+
+struct Result
+{
+    uint64_t move;
+    int depth;
+};
+
+struct Depth
+{
+    int operator()(const Result& result) const { return result.depth; }
+};
+
+int depthOf(uint64_t key)
+{
+    return std::min(std::countr_zero(non_std::containers::mix64(key) | (1ull << 12)), 12);
+}
+
+template <typename TReplacement>
+void replay(const std::string& name, const std::vector<uint64_t>& trace)
+{
+    non_std::containers::FixedSizeHashTableOpenHashingWithAge<uint64_t, Result, std::hash<uint64_t>,
+        non_std::containers::AgeByGeneration, TReplacement> table(TraceEntries);
+    std::size_t hits = 0;
+    double saved = 0;
+    double work = 0;
+    Stopwatch stopwatch;
+    for (std::size_t i = 0; i < trace.size(); ++i)
+    {
+        if (i % GenerationLength == 0)
+        {
+            table.newGeneration();
+        }
+        const auto key = trace[i];
+        const double cost = double(1u << depthOf(key));
+        work += cost;
+        if (table.get(key) != nullptr)
+        {
+            ++hits;
+            saved += cost;
+        }
+        else
+        {
+            table.store(key, Result{key, depthOf(key)});
+        }
+    }
+    report("age_table/trace " + name, stopwatch.elapsedNs() / trace.size());
+    reportPercent("age_table/trace " + name + " hit rate", 100.0 * hits / trace.size());
+    reportPercent("age_table/trace " + name + " work saved", 100.0 * saved / work);
+}
+
+// Same trace against tables of one memory budget, storing keys or signatures. The value holds the key,
+// so hits on a wrong entry are counted.
+constexpr std::size_t Budget = 1u << 20;
+
+template <typename TKeys>
+void budget(const std::string& name, const std::vector<uint64_t>& trace)
+{
+    using Table = non_std::containers::FixedSizeHashTableOpenHashingWithAge<uint64_t, uint64_t, std::hash<uint64_t>,
+        non_std::containers::AgeByRecency, non_std::containers::ReplaceOldest, TKeys>;
+    auto table = Table::withMemoryBudget(Budget);
+    std::size_t hits = 0;
+    std::size_t wrong = 0;
+    Stopwatch stopwatch;
+    for (auto key : trace)
+    {
+        if (uint64_t* val = table.get(key))
+        {
+            ++hits;
+            wrong += *val != key;
+        }
+        else
+        {
+            table.store(key, key);
+        }
+    }
+    const auto nsPerOp = stopwatch.elapsedNs() / trace.size();
+    report("age_table/1MB " + name + " entries", double(table.capacity()), "entries");
+    report("age_table/1MB " + name, nsPerOp);
+    reportPercent("age_table/1MB " + name + " hit rate", 100.0 * hits / trace.size());
+    reportPercent("age_table/1MB " + name + " wrong hits", 100.0 * wrong / trace.size());
+}
+
+// Page placement of a 2M and an 8M-entry table (48 and 192 MB). Both are far past the reach of the
+// 4 KB page TLB entries, so random lookups miss the TLB too; huge pages cut the page walks. perf is
+// not available here, so TLB misses are not counted: the huge page backed memory shows whether
+// the kernel granted the advice, the dependent lookups show the latency.
+constexpr std::size_t PageChains = 1u << 20;
+
+void pages(const std::string& name, std::size_t entries, const non_std::internal::PagePolicy& policy)
+{
+    const auto before = hugePageMb();
+    Stopwatch construction;
+    RecencyTable table(entries, policy);
+    const auto constructionNs = construction.elapsedNs();
+    std::vector<uint64_t> keys;
+    for (auto key : randomKeys(9, table.capacity() / 2))
+    {
+        table.store(key, 0);
+    }
+    for (auto key : randomKeys(9, table.capacity() / 2))
+    {
+        if (table.probe(key))
+        {
+            keys.push_back(key);
+        }
+    }
+    // Each kept key holds the next one, so a lookup depends on the one before: latency, not throughput.
+    for (std::size_t i = 0; i < keys.size(); ++i)
+    {
+        table.store(keys[i], keys[(i + 1) % keys.size()]);
+    }
+    const std::string prefix = "age_table/pages " + std::to_string(table.memoryUsage() >> 20) + " MB " + name;
+    report(prefix + " construct", constructionNs / 1e6, "ms");
+    report(prefix + " huge page backed", hugePageMb() - before, "MB");
+
+    uint64_t key = keys.front();
+    Stopwatch dependent;
+    for (std::size_t i = 0; i < PageChains; ++i)
+    {
+        key = *table.probe(key);
+    }
+    doNotOptimize(key);
+    report(prefix + " dependent probe", dependent.elapsedNs() / PageChains);
+
+    std::mt19937_64 rng(10);
+    uint64_t found = 0;
+    Stopwatch independent;
+    for (std::size_t i = 0; i < PageChains; ++i)
+    {
+        found += table.get(keys[rng() % keys.size()]) != nullptr;
+    }
+    doNotOptimize(found);
+    report(prefix + " get", independent.elapsedNs() / PageChains);
+}
+
+void pages()
+{
+    for (std::size_t entries : {std::size_t(1) << 21, std::size_t(1) << 23})
+    {
+        pages("4 KB pages", entries, {});
+        pages("huge pages", entries, {true});
+        pages("huge pages interleaved", entries, {true, true});
+        pages("huge pages 4 init threads", entries, {true, false, 4});
+    }
+}
+
+// Restart of a process which kept a 2M-entry table warm with a Zipf trace: a cold start refills the
+// table from the trace, a warm start maps a snapshot saved before the restart. Warm means a window of
+// the trace hits at least 95% as often as before the restart. The snapshot is still in the page
+// cache, as after a restart on the same host.
+constexpr std::size_t RestartEntries = 1u << 21;
+constexpr std::size_t RestartWindow = 1u << 16;
+constexpr std::size_t RestartWarmup = 1u << 24;
+
+std::size_t replayWindow(RecencyTable& table, const std::vector<uint64_t>& trace, std::size_t begin)
+{
+    std::size_t hits = 0;
+    for (std::size_t i = begin; i < begin + RestartWindow; ++i)
+    {
+        if (table.get(trace[i]) != nullptr)
+        {
+            ++hits;
+        }
+        else
+        {
+            table.store(trace[i], trace[i]);
+        }
+    }
+    return hits;
+}
+
+// Time from the start until a window is warm, including the time to create or open the table.
+template <typename TStart>
+void restartToWarm(const std::string& name, const std::vector<uint64_t>& trace, std::size_t warmHits, TStart start)
+{
+    Stopwatch stopwatch;
+    RecencyTable table = start();
+    const auto startNs = stopwatch.elapsedNs();
+    const auto firstHits = replayWindow(table, trace, RestartWarmup);
+    std::size_t begin = RestartWarmup;
+    for (auto hits = firstHits; hits * 100 < warmHits * 95 && begin + 2 * RestartWindow <= trace.size(); )
+    {
+        begin += RestartWindow;
+        hits = replayWindow(table, trace, begin);
+    }
+    report("age_table/restart " + name + " start", startNs / 1e6, "ms");
+    reportPercent("age_table/restart " + name + " hit rate of first window", 100.0 * firstHits / RestartWindow);
+    report("age_table/restart " + name + " to warm", stopwatch.elapsedNs() / 1e6, "ms");
+    report("age_table/restart " + name + " lookups to warm", double(begin + RestartWindow - RestartWarmup), "lookups");
+}
+
+void restart()
+{
+    const auto trace = zipfTrace(1u << 23, 2 * RestartWarmup, 0.9, 8);
+    const auto path = (std::filesystem::temp_directory_path() / "non_std_age_table_bench.bin").string();
+    std::size_t warmHits = 0;
+    {
+        RecencyTable table(RestartEntries);
+        for (std::size_t begin = 0; begin < RestartWarmup; begin += RestartWindow)
+        {
+            warmHits = replayWindow(table, trace, begin);
+        }
+        Stopwatch stopwatch;
+        table.save(path);
+        report("age_table/restart save " + std::to_string(table.memoryUsage() >> 20) + " MB", stopwatch.elapsedNs() / 1e6, "ms");
+    }
+    reportPercent("age_table/restart hit rate before restart", 100.0 * warmHits / RestartWindow);
+    restartToWarm("cold", trace, warmHits, []() { return RecencyTable(RestartEntries); });
+    restartToWarm("openMapped", trace, warmHits, [&path]() { return RecencyTable::openMapped(path); });
+    restartToWarm("openMapped populate", trace, warmHits, [&path]() { return RecencyTable::openMapped(path, true); });
+    std::remove(path.c_str());
+}
+
+}  // namespace
+
+void run()
+{
+    run<RecencyTable>("recency");
+    run<GenerationTable>("generation");
+    prefetchDistance();
+    restart();
+    pages();
+
+    const auto trace = zipfTrace(TraceUniverse, TraceLength, 0.9, 5);
+    replay<non_std::containers::ReplaceOldest>("oldest", trace);
+    replay<non_std::containers::ReplaceAlways>("always", trace);
+    replay<non_std::containers::ReplaceLowestPriority<Depth>>("lowest depth", trace);
+    replay<non_std::containers::ReplaceTwoTier<Depth>>("two tier", trace);
+
+    budget<non_std::containers::FullKeys>("full keys", trace);
+    budget<non_std::containers::KeySignatures<uint32_t>>("32-bit signatures", trace);
+    budget<non_std::containers::KeySignatures<uint16_t>>("16-bit signatures", trace);
+}
+
+}  // namespace bench::age_table
@@ -0,0 +1,8 @@
+#pragma once
+
+namespace bench::age_table
+{
+
+void run();
+
+}  // namespace bench::age_table
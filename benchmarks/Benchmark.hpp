@@ -0,0 +1,84 @@
+#pragma once
+
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+namespace bench
+{
+
+// Keeps the optimizer from discarding a value computed inside a measured loop.
+template <typename T>
+inline void doNotOptimize(const T& value)
+{
+#ifdef __GNUC__
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile const void* sink;
+    sink = &value;
+#endif // __GNUC__
+}
+
+class Stopwatch
+{
+public:
+    Stopwatch()
+        : start_(std::chrono::steady_clock::now())
+    {
+    }
+
+    double elapsedNs() const
+    {
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start_).count();
+    }
+
+private:
+    std::chrono::steady_clock::time_point start_;
+};
+
+inline void report(const std::string& name, double value, const std::string& unit)
+{
+    std::cout << std::left << std::setw(64) << name << std::right << std::setw(12)
+              << std::fixed << std::setprecision(2) << value << " " << unit << std::endl;
+}
+
+inline void report(const std::string& name, double nsPerOp)
+{
+    report(name, nsPerOp, "ns/op");
+}
+
+inline void reportPercent(const std::string& name, double percent)
+{
+    report(name, percent, "%");
+}
+
+// Resident memory of the process (/proc/self/statm), 0 where it is not reported.
+inline double residentBytes()
+{
+    std::ifstream in("/proc/self/statm");
+    double size = 0;
+    double resident = 0;
+    in >> size >> resident;
+    return resident * 4096;
+}
+
+// Memory of the process backed by transparent huge pages (AnonHugePages), 0 where it is not reported.
+inline double hugePageMb()
+{
+    std::ifstream in("/proc/self/smaps_rollup");
+    std::string field;
+    double kb = 0;
+    while (in >> field)
+    {
+        if (field == "AnonHugePages:")
+        {
+            in >> kb;
+            break;
+        }
+    }
+    return kb / 1024;
+}
+
+}  // namespace bench
@@ -0,0 +1,128 @@
+#include "ConcurrentPoolAllocatorBenchmarks.hpp"
+#include "Benchmark.hpp"
+
+#include <non_std/ConcurrentPoolAllocator.hpp>
+
+#include <barrier>
+#include <cstdlib>
+#include <stdint.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace bench::concurrent_pool_allocator
+{
+
+namespace
+{
+
+struct Node
+{
+    uint64_t key;
+    uint64_t val;
+    Node* next;
+};
+
+struct PoolSource
+{
+    static constexpr const char* name = "pool";
+    ConcurrentPoolAllocator<Node> allocator;
+    Node* allocate() { return allocator.allocate(); }
+    void dealocate(Node* in) { allocator.dealocate(in); }
+};
+
+struct MallocSource
+{
+    static constexpr const char* name = "malloc";
+    Node* allocate() { return static_cast<Node*>(std::malloc(sizeof(Node))); }
+    void dealocate(Node* in) { std::free(in); }
+};
+
+constexpr std::size_t Batch = 512;
+constexpr std::size_t Rounds = 2000;
+
+// Every thread frees what it allocated.
+template <typename TSource>
+void threadLocalAllocFree(unsigned threads)
+{
+    std::vector<std::thread> workers;
+    Stopwatch stopwatch;
+    for (unsigned t = 0; t < threads; ++t)
+    {
+        workers.emplace_back([]() {
+            TSource source;
+            std::vector<Node*> batch(Batch);
+            for (std::size_t round = 0; round < Rounds; ++round)
+            {
+                for (auto& ptr : batch)
+                {
+                    ptr = source.allocate();
+                    doNotOptimize(ptr);
+                }
+                for (auto* ptr : batch)
+                {
+                    source.dealocate(ptr);
+                }
+            }
+        });
+    }
+    for (auto& worker : workers)
+    {
+        worker.join();
+    }
+    report(std::string("concurrent_pool_allocator/local ") + TSource::name + " threads=" + std::to_string(threads),
+           stopwatch.elapsedNs() / (Batch * Rounds));
+}
+
+// Every thread frees the batch allocated by its neighbour, the producer/consumer shape of Queue.
+template <typename TSource>
+void crossThreadAllocFree(unsigned threads)
+{
+    std::vector<std::vector<Node*>> batches(threads, std::vector<Node*>(Batch));
+    std::barrier sync(threads);
+    std::vector<std::thread> workers;
+    Stopwatch stopwatch;
+    for (unsigned t = 0; t < threads; ++t)
+    {
+        workers.emplace_back([t, threads, &batches, &sync]() {
+            TSource source;
+            for (std::size_t round = 0; round < Rounds; ++round)
+            {
+                for (auto& ptr : batches[t])
+                {
+                    ptr = source.allocate();
+                }
+                sync.arrive_and_wait();
+                for (auto* ptr : batches[(t + 1) % threads])
+                {
+                    source.dealocate(ptr);
+                }
+                sync.arrive_and_wait();
+            }
+        });
+    }
+    for (auto& worker : workers)
+    {
+        worker.join();
+    }
+    report(std::string("concurrent_pool_allocator/cross_thread ") + TSource::name + " threads=" + std::to_string(threads),
+           stopwatch.elapsedNs() / (Batch * Rounds));
+}
+
+}  // namespace
+
+void run()
+{
+    for (unsigned threads : {1u, 2u, 4u, 8u, 16u})
+    {
+        threadLocalAllocFree<PoolSource>(threads);
+        threadLocalAllocFree<MallocSource>(threads);
+    }
+    for (unsigned threads : {2u, 4u, 8u, 16u})
+    {
+        crossThreadAllocFree<PoolSource>(threads);
+        crossThreadAllocFree<MallocSource>(threads);
+    }
+}
+
+}  // namespace bench::concurrent_pool_allocator
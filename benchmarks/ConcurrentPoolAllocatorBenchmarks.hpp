@@ -0,0 +1,8 @@
+#pragma once
+
+namespace bench::concurrent_pool_allocator
+{
+
+void run();
+
+}  // namespace bench::concurrent_pool_allocator
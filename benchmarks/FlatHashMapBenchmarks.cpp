@@ -0,0 +1,101 @@
+#include "FlatHashMapBenchmarks.hpp"
+#include "Benchmark.hpp"
+
+#include <non_std/containers/FlatHashMap.hpp>
+#include <non_std/containers/HashMap.hpp>
+
+#include <random>
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace bench::flat_hash_map
+{
+
+namespace
+{
+
+constexpr std::size_t Keys = 1u << 20;
+constexpr std::size_t Lookups = 1u << 22;
+
+std::vector<uint64_t> randomKeys(uint64_t seed, std::size_t count)
+{
+    std::vector<uint64_t> keys(count);
+    std::mt19937_64 rng(seed);
+    for (auto& key : keys)
+    {
+        key = rng();
+    }
+    return keys;
+}
+
+// Same interface over all three maps: insert(key), find(key) -> value or 0 when missing.
+struct Flat
+{
+    static constexpr const char* Name = "FlatHashMap";
+    non_std::containers::FlatHashMap<uint64_t, uint64_t, 10> map;
+    void insert(uint64_t key) { map.store(key, key); }
+    uint64_t find(uint64_t key) { auto* out = map.get(key); return out != nullptr ? *out : 0; }
+};
+
+struct Chained
+{
+    static constexpr const char* Name = "HashMap";
+    non_std::containers::HashMap<uint64_t, uint64_t, 10> map;
+    void insert(uint64_t key) { map.store(key, key); }
+    uint64_t find(uint64_t key) { auto* out = map.get(key); return out != nullptr ? *out : 0; }
+};
+
+struct Std
+{
+    static constexpr const char* Name = "std::unordered_map";
+    std::unordered_map<uint64_t, uint64_t> map;
+    void insert(uint64_t key) { map.emplace(key, key); }
+    uint64_t find(uint64_t key) { auto it = map.find(key); return it != map.end() ? it->second : 0; }
+};
+
+template <typename TMap>
+void run(const std::vector<uint64_t>& keys, const std::vector<uint64_t>& hits, const std::vector<uint64_t>& misses)
+{
+    const std::string name = TMap::Name;
+    TMap map;
+    {
+        Stopwatch stopwatch;
+        for (auto key : keys)
+        {
+            map.insert(key);
+        }
+        report("flat_hash_map/insert " + name, stopwatch.elapsedNs() / keys.size());
+    }
+    for (auto [kind, lookups] : {std::pair{"hit", &hits}, std::pair{"miss", &misses}})
+    {
+        uint64_t sum = 0;
+        Stopwatch stopwatch;
+        for (auto key : *lookups)
+        {
+            sum += map.find(key);
+        }
+        doNotOptimize(sum);
+        report(std::string("flat_hash_map/lookup ") + kind + " " + name, stopwatch.elapsedNs() / lookups->size());
+    }
+}
+
+}  // namespace
+
+void run()
+{
+    const auto keys = randomKeys(1, Keys);
+    const auto misses = randomKeys(2, Lookups);
+    std::vector<uint64_t> hits(Lookups);
+    std::mt19937_64 rng(3);
+    for (auto& key : hits)
+    {
+        key = keys[rng() % keys.size()];
+    }
+    run<Flat>(keys, hits, misses);
+    run<Chained>(keys, hits, misses);
+    run<Std>(keys, hits, misses);
+}
+
+}  // namespace bench::flat_hash_map
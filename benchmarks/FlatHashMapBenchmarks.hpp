@@ -0,0 +1,8 @@
+#pragma once
+
+namespace bench::flat_hash_map
+{
+
+void run();
+
+}  // namespace bench::flat_hash_map
@@ -0,0 +1,104 @@
+#include "FrozenHashMapBenchmarks.hpp"
+#include "Benchmark.hpp"
+
+#include <non_std/containers/FrozenHashMap.hpp>
+#include <non_std/containers/HashMap.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <random>
+#include <stdint.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace bench::frozen_hash_map
+{
+
+namespace
+{
+
+using Map = non_std::containers::HashMap<uint64_t, uint64_t, 10>;
+using Frozen = non_std::containers::FrozenHashMap<uint64_t, uint64_t>;
+
+constexpr std::size_t Keys = 1u << 21;
+
+std::vector<uint64_t> randomKeys(uint64_t seed)
+{
+    std::vector<uint64_t> keys(Keys);
+    std::mt19937_64 rng(seed);
+    for (auto& key : keys)
+    {
+        key = rng();
+    }
+    return keys;
+}
+
+template <typename TMap>
+uint64_t lookupAll(const TMap& map, const std::vector<uint64_t>& keys)
+{
+    uint64_t sum = 0;
+    for (auto key : keys)
+    {
+        auto* val = map.get(key);
+        sum += val != nullptr ? *val : 1;
+    }
+    return sum;
+}
+
+}  // namespace
+
+void run()
+{
+    const auto keys = randomKeys(1);
+    const auto misses = randomKeys(2);
+    std::vector<uint64_t> hits = keys;
+    std::shuffle(hits.begin(), hits.end(), std::mt19937_64(3));
+    const auto path = (std::filesystem::temp_directory_path() / "non_std_frozen_hash_map_bench.bin").string();
+
+    Map map;
+    {
+        Stopwatch stopwatch;
+        for (auto key : keys)
+        {
+            map.store(key, key);
+        }
+        report("frozen_hash_map/build HashMap (per key)", stopwatch.elapsedNs() / Keys);
+    }
+    {
+        Stopwatch stopwatch;
+        auto frozen = Frozen::freeze(map);
+        report("frozen_hash_map/build freeze() (per key)", stopwatch.elapsedNs() / Keys);
+        frozen.save(path);
+    }
+    {
+        Stopwatch stopwatch;
+        auto frozen = Frozen::open(path);
+        report("frozen_hash_map/load open() (total)", stopwatch.elapsedNs());
+        doNotOptimize(lookupAll(frozen, hits));
+        report("frozen_hash_map/load open() + first lookup pass (per key)", stopwatch.elapsedNs() / Keys);
+    }
+    {
+        Stopwatch stopwatch;
+        auto frozen = Frozen::open(path);
+        Stopwatch lookups;
+        doNotOptimize(lookupAll(frozen, hits));
+        report("frozen_hash_map/lookup hit FrozenHashMap", lookups.elapsedNs() / Keys);
+        Stopwatch missLookups;
+        doNotOptimize(lookupAll(frozen, misses));
+        report("frozen_hash_map/lookup miss FrozenHashMap", missLookups.elapsedNs() / Keys);
+    }
+    {
+        const Map& live = map;
+        Stopwatch lookups;
+        doNotOptimize(lookupAll(live, hits));
+        report("frozen_hash_map/lookup hit HashMap", lookups.elapsedNs() / Keys);
+        Stopwatch missLookups;
+        doNotOptimize(lookupAll(live, misses));
+        report("frozen_hash_map/lookup miss HashMap", missLookups.elapsedNs() / Keys);
+    }
+    std::remove(path.c_str());
+}
+
+}  // namespace bench::frozen_hash_map
@@ -0,0 +1,8 @@
+#pragma once
+
+namespace bench::frozen_hash_map
+{
+
+void run();
+
+}  // namespace bench::frozen_hash_map
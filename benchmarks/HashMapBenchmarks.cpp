@@ -0,0 +1,248 @@
+#include "HashMapBenchmarks.hpp"
+#include "Benchmark.hpp"
+
+#include <non_std/containers/HashMap.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <span>
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace bench::hash_map
+{
+
+namespace
+{
+
+using Map = non_std::containers::HashMap<uint64_t, uint64_t, 10>;
+
+constexpr std::size_t Keys = 1u << 21;
+
+std::vector<uint64_t> makeKeys(bool lowBitPattern)
+{
+    std::vector<uint64_t> keys(Keys);
+    std::mt19937_64 rng(1);
+    for (std::size_t i = 0; i < Keys; ++i)
+    {
+        // Low bit pattern: every key is a multiple of 4096, as e.g. page addresses are.
+        keys[i] = lowBitPattern ? (uint64_t(i) << 12) : rng();
+    }
+    std::shuffle(keys.begin(), keys.end(), rng);
+    return keys;
+}
+
+// Reports mean insert cost and the slowest single insert, which shows the cost of a resize step.
+template <typename TInsert>
+void insertLatency(const std::string& name, TInsert insert, const std::vector<uint64_t>& keys)
+{
+    double worstNs = 0;
+    Stopwatch total;
+    for (auto key : keys)
+    {
+        auto start = std::chrono::steady_clock::now();
+        insert(key);
+        worstNs = std::max(worstNs, std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count());
+    }
+    report("hash_map/insert mean " + name, total.elapsedNs() / keys.size());
+    report("hash_map/insert worst " + name, worstNs);
+}
+
+template <typename TFind>
+void lookup(const std::string& name, TFind find, const std::vector<uint64_t>& keys)
+{
+    uint64_t sum = 0;
+    Stopwatch stopwatch;
+    for (auto key : keys)
+    {
+        sum += find(key);
+    }
+    doNotOptimize(sum);
+    report("hash_map/lookup hit " + name, stopwatch.elapsedNs() / keys.size());
+}
+
+// Sliding window: every step stores a new key and erases the oldest one.
+template <typename TStore, typename TErase>
+void churn(const std::string& name, TStore store, TErase erase, const std::vector<uint64_t>& keys)
+{
+    constexpr std::size_t Window = 1u << 16;
+    for (std::size_t i = 0; i < Window; ++i)
+    {
+        store(keys[i]);
+    }
+    Stopwatch stopwatch;
+    for (std::size_t i = Window; i < keys.size(); ++i)
+    {
+        store(keys[i]);
+        erase(keys[i - Window]);
+    }
+    report("hash_map/churn store+erase " + name, stopwatch.elapsedNs() / (keys.size() - Window));
+}
+
+void runChurnAndIteration()
+{
+    const auto keys = makeKeys(false);
+    {
+        Map map;
+        churn("HashMap", [&map](uint64_t key) { map.store(key, key); }, [&map](uint64_t key) { map.erase(key); }, keys);
+        for (auto key : keys)
+        {
+            map.store(key, key);
+        }
+        uint64_t sum = 0;
+        Stopwatch stopwatch;
+        map.forEach([&sum](const uint64_t&, uint64_t& val) { sum += val; });
+        doNotOptimize(sum);
+        report("hash_map/iterate HashMap", stopwatch.elapsedNs() / map.size());
+    }
+    {
+        std::unordered_map<uint64_t, uint64_t> map;
+        churn("std::unordered_map", [&map](uint64_t key) { map.emplace(key, key); }, [&map](uint64_t key) { map.erase(key); }, keys);
+        for (auto key : keys)
+        {
+            map.emplace(key, key);
+        }
+        uint64_t sum = 0;
+        Stopwatch stopwatch;
+        for (auto& [key, val] : map)
+        {
+            sum += val;
+        }
+        doNotOptimize(sum);
+        report("hash_map/iterate std::unordered_map", stopwatch.elapsedNs() / map.size());
+    }
+}
+
+// 8M entries: ~64 MB of buckets and ~200 MB of nodes, far more than any last level cache.
+void runBatchLookup()
+{
+    constexpr std::size_t TableKeys = 1u << 23;
+    constexpr std::size_t Batch = 1024;
+    Map map;
+    std::vector<uint64_t> keys(TableKeys);
+    std::mt19937_64 rng(2);
+    for (auto& key : keys)
+    {
+        key = rng();
+        map.store(key, key);
+    }
+    std::vector<uint64_t> lookups(Keys);
+    for (auto& key : lookups)
+    {
+        key = keys[rng() % keys.size()];
+    }
+
+    uint64_t sum = 0;
+    Stopwatch scalar;
+    for (auto key : lookups)
+    {
+        sum += *map.get(key);
+    }
+    report("hash_map/lookup 8M scalar get()", scalar.elapsedNs() / lookups.size());
+
+    std::vector<uint64_t*> out(Batch);
+    Stopwatch batched;
+    for (std::size_t begin = 0; begin < lookups.size(); begin += Batch)
+    {
+        map.getBatch(std::span<const uint64_t>(lookups).subspan(begin, Batch), out);
+        for (auto* val : out)
+        {
+            sum += *val;
+        }
+    }
+    report("hash_map/lookup 8M getBatch()", batched.elapsedNs() / lookups.size());
+    doNotOptimize(sum);
+}
+
+// 8M entries with 4 KB or huge pages under the bucket table and the node slabs.
+void runPages(const std::string& name, const non_std::internal::PagePolicy& pages)
+{
+    constexpr std::size_t TableKeys = 1u << 23;
+    const auto before = hugePageMb();
+    Map map(pages);
+    std::vector<uint64_t> keys(TableKeys);
+    std::mt19937_64 rng(4);
+    for (auto& key : keys)
+    {
+        key = rng();
+        map.store(key, key);
+    }
+    report("hash_map/lookup 8M " + name + " huge page backed", hugePageMb() - before, "MB");
+    uint64_t sum = 0;
+    Stopwatch stopwatch;
+    for (std::size_t i = 0; i < Keys; ++i)
+    {
+        sum += *map.get(keys[rng() % keys.size()]);
+    }
+    doNotOptimize(sum);
+    report("hash_map/lookup 8M " + name + " get()", stopwatch.elapsedNs() / Keys);
+}
+
+// 2M entries, each lookup's key prefetched distance lookups ahead (0 = no prefetch).
+void runPrefetchDistance()
+{
+    constexpr std::size_t TableKeys = 1u << 21;
+    Map map;
+    std::vector<uint64_t> keys(TableKeys);
+    std::mt19937_64 rng(3);
+    for (auto& key : keys)
+    {
+        key = rng();
+        map.store(key, key);
+    }
+    std::vector<uint64_t> lookups(Keys);
+    for (auto& key : lookups)
+    {
+        key = keys[rng() % keys.size()];
+    }
+
+    for (std::size_t distance : {0u, 1u, 2u, 4u, 8u, 16u, 32u, 64u})
+    {
+        uint64_t sum = 0;
+        Stopwatch stopwatch;
+        for (std::size_t i = 0; i < lookups.size(); ++i)
+        {
+            if (distance != 0 && i + distance < lookups.size())
+            {
+                map.prefetch(lookups[i + distance]);
+            }
+            sum += *map.get(lookups[i]);
+        }
+        doNotOptimize(sum);
+        report("hash_map/lookup 2M prefetch distance=" + std::to_string(distance), stopwatch.elapsedNs() / lookups.size());
+    }
+}
+
+void run(bool lowBitPattern)
+{
+    const auto keys = makeKeys(lowBitPattern);
+    const std::string suffix = lowBitPattern ? " keys=multiples_of_4096" : " keys=random";
+    {
+        Map map;
+        insertLatency("HashMap" + suffix, [&map](uint64_t key) { map.store(key, key); }, keys);
+        lookup("HashMap" + suffix, [&map](uint64_t key) { return *map.get(key); }, keys);
+    }
+    {
+        std::unordered_map<uint64_t, uint64_t> map;
+        insertLatency("std::unordered_map" + suffix, [&map](uint64_t key) { map.emplace(key, key); }, keys);
+        lookup("std::unordered_map" + suffix, [&map](uint64_t key) { return map.find(key)->second; }, keys);
+    }
+}
+
+}  // namespace
+
+void run()
+{
+    run(false);
+    run(true);
+    runChurnAndIteration();
+    runBatchLookup();
+    runPrefetchDistance();
+    runPages("4 KB pages", {});
+    runPages("huge pages", {true});
+}
+
+}  // namespace bench::hash_map
@@ -0,0 +1,8 @@
+#pragma once
+
+namespace bench::hash_map
+{
+
+void run();
+
+}  // namespace bench::hash_map
@@ -0,0 +1,92 @@
+#include "LargeValueBenchmarks.hpp"
+#include "Benchmark.hpp"
+
+#include <non_std/containers/FixedSizeHashTableOpenHashingWithAge.hpp>
+#include <non_std/containers/HashMap.hpp>
+
+#include <memory>
+#include <random>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace bench::large_value
+{
+
+namespace
+{
+
+struct Big
+{
+    uint64_t words[32];
+
+    Big() = default;
+    explicit Big(uint64_t seed) noexcept
+    {
+        for (auto& word : words)
+        {
+            word = seed++;
+        }
+    }
+};
+static_assert(sizeof(Big) == 256);
+
+constexpr std::size_t Keys = 1u << 19;
+
+struct IdentityHash
+{
+    uint64_t operator()(uint64_t in) const { return in; }
+};
+
+std::vector<uint64_t> randomKeys()
+{
+    std::vector<uint64_t> keys(Keys);
+    std::mt19937_64 rng(1);
+    for (auto& key : keys)
+    {
+        key = rng();
+    }
+    return keys;
+}
+
+template <typename TMap, typename TInsert>
+void insert(const std::string& name, const std::vector<uint64_t>& keys, TInsert insertOne)
+{
+    auto map = std::make_unique<TMap>();
+    if constexpr (requires { map->clear(); })
+    {
+        // Warm pass, so pools and bucket table are faulted in and the copies are what is measured.
+        for (auto key : keys)
+        {
+            insertOne(*map, key);
+        }
+        map->clear();
+    }
+    Stopwatch stopwatch;
+    for (auto key : keys)
+    {
+        insertOne(*map, key);
+    }
+    report("large_value/" + name, stopwatch.elapsedNs() / keys.size());
+    doNotOptimize(map);
+}
+
+}  // namespace
+
+void run()
+{
+    const auto keys = randomKeys();
+
+    using Map = non_std::containers::HashMap<Big, uint64_t, 10>;
+    insert<Map>("HashMap operator[] then assign", keys, [](Map& map, uint64_t key) { *map[key] = Big(key); });
+    insert<Map>("HashMap store", keys, [](Map& map, uint64_t key) { map.store(key, Big(key)); });
+    insert<Map>("HashMap insertOrAssign", keys, [](Map& map, uint64_t key) { map.insertOrAssign(key, Big(key)); });
+    insert<Map>("HashMap tryEmplace", keys, [](Map& map, uint64_t key) { map.tryEmplace(key, key); });
+
+    using AgeTable = non_std::containers::FixedSizeHashTableOpenHashingWithAge<uint64_t, Big, IdentityHash>;
+    insert<AgeTable>("AgeTable operator[] then assign", keys, [](AgeTable& table, uint64_t key) { *table[key].operator Big*() = Big(key); });
+    insert<AgeTable>("AgeTable store", keys, [](AgeTable& table, uint64_t key) { table.store(key, Big(key)); });
+    insert<AgeTable>("AgeTable tryEmplace", keys, [](AgeTable& table, uint64_t key) { table.tryEmplace(key, key); });
+}
+
+}  // namespace bench::large_value
@@ -0,0 +1,8 @@
+#pragma once
+
+namespace bench::large_value
+{
+
+void run();
+
+}  // namespace bench::large_value
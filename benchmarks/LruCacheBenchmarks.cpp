@@ -0,0 +1,102 @@
+#include "LruCacheBenchmarks.hpp"
+#include "Benchmark.hpp"
+#include "Zipf.hpp"
+
+#include <non_std/containers/LruCache.hpp>
+
+#include <list>
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace bench::lru_cache
+{
+
+namespace
+{
+
+constexpr std::size_t Universe = 1u << 20;
+constexpr std::size_t Requests = 1u << 22;
+
+struct NonStd
+{
+    static constexpr const char* Name = "LruCache";
+    explicit NonStd(std::size_t capacity) : cache(capacity) {}
+    non_std::containers::LruCache<uint64_t, uint64_t> cache;
+    const uint64_t* get(uint64_t key) { return cache.get(key); }
+    void put(uint64_t key, uint64_t val) { cache.store(key, val); }
+};
+
+// The usual std::list + std::unordered_map LRU.
+struct Std
+{
+    static constexpr const char* Name = "std::list LRU";
+    explicit Std(std::size_t capacityIn) : capacity(capacityIn) { index.reserve(capacity); }
+    std::size_t capacity;
+    std::list<std::pair<uint64_t, uint64_t>> order;
+    std::unordered_map<uint64_t, std::list<std::pair<uint64_t, uint64_t>>::iterator> index;
+
+    const uint64_t* get(uint64_t key)
+    {
+        auto it = index.find(key);
+        if (it == index.end())
+        {
+            return nullptr;
+        }
+        order.splice(order.begin(), order, it->second);
+        return &it->second->second;
+    }
+
+    void put(uint64_t key, uint64_t val)
+    {
+        if (index.size() == capacity)
+        {
+            index.erase(order.back().first);
+            order.pop_back();
+        }
+        order.emplace_front(key, val);
+        index.emplace(key, order.begin());
+    }
+};
+
+// Read through cache: a miss stores the key.
+template <typename TCache>
+void run(const std::vector<uint64_t>& trace, std::size_t capacity)
+{
+    const std::string name = std::string(TCache::Name) + " cap " + std::to_string(capacity);
+    TCache cache(capacity);
+    std::size_t hits = 0;
+    uint64_t sum = 0;
+    Stopwatch stopwatch;
+    for (auto key : trace)
+    {
+        if (const uint64_t* val = cache.get(key))
+        {
+            ++hits;
+            sum += *val;
+        }
+        else
+        {
+            cache.put(key, key);
+        }
+    }
+    doNotOptimize(sum);
+    report("lru_cache/zipf get or put " + name, stopwatch.elapsedNs() / trace.size());
+    reportPercent("lru_cache/zipf hit rate " + name, 100.0 * hits / trace.size());
+}
+
+}  // namespace
+
+void run()
+{
+    const auto trace = zipfTrace(Universe, Requests, 0.99, 17);
+    for (auto capacity : {Universe / 100, Universe / 10})
+    {
+        run<NonStd>(trace, capacity);
+        run<Std>(trace, capacity);
+    }
+}
+
+}  // namespace bench::lru_cache
@@ -0,0 +1,8 @@
+#pragma once
+
+namespace bench::lru_cache
+{
+
+void run();
+
+}  // namespace bench::lru_cache
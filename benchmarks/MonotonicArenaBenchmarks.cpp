@@ -0,0 +1,115 @@
+#include "MonotonicArenaBenchmarks.hpp"
+#include "Benchmark.hpp"
+
+#include <non_std/MonotonicArena.hpp>
+#include <non_std/PoolAlocator.hpp>
+
+#include <cstdlib>
+#include <random>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace bench::monotonic_arena
+{
+
+namespace
+{
+
+constexpr std::size_t Requests = 20000;
+
+// Every "request" allocates a burst of objects and drops all of them at the end.
+std::vector<std::size_t> requestSizes(std::size_t objects, bool mixed)
+{
+    std::vector<std::size_t> sizes(objects, 64);
+    if (mixed)
+    {
+        std::mt19937 rng(7);
+        for (auto& size : sizes)
+        {
+            size = 16 + rng() % 241;
+        }
+    }
+    return sizes;
+}
+
+void mallocFree(const std::vector<std::size_t>& sizes, const std::string& name)
+{
+    std::vector<void*> ptrs(sizes.size());
+    Stopwatch stopwatch;
+    for (std::size_t request = 0; request < Requests; ++request)
+    {
+        for (std::size_t i = 0; i < sizes.size(); ++i)
+        {
+            ptrs[i] = std::malloc(sizes[i]);
+            doNotOptimize(ptrs[i]);
+        }
+        for (auto* ptr : ptrs)
+        {
+            std::free(ptr);
+        }
+    }
+    report("monotonic_arena/" + name + " malloc/free", stopwatch.elapsedNs() / (Requests * sizes.size()));
+}
+
+void arena(const std::vector<std::size_t>& sizes, const std::string& name, bool hugePages)
+{
+    MonotonicArena arena(MonotonicArena::DefaultChunkSize, hugePages);
+    Stopwatch stopwatch;
+    for (std::size_t request = 0; request < Requests; ++request)
+    {
+        auto checkpoint = arena.checkpoint();
+        for (auto size : sizes)
+        {
+            doNotOptimize(arena.allocate(size));
+        }
+        arena.rewind(checkpoint);
+    }
+    report("monotonic_arena/" + name + (hugePages ? " arena+huge_pages" : " arena"),
+           stopwatch.elapsedNs() / (Requests * sizes.size()));
+}
+
+// PoolAllocator only serves one size, so it is measured on the fixed size workload only.
+void pool(const std::vector<std::size_t>& sizes, const std::string& name)
+{
+    struct Block
+    {
+        unsigned char bytes[64];
+    };
+    PoolAllocator<Block> allocator;
+    std::vector<Block*> ptrs(sizes.size());
+    Stopwatch stopwatch;
+    for (std::size_t request = 0; request < Requests; ++request)
+    {
+        for (auto& ptr : ptrs)
+        {
+            ptr = allocator.allocate();
+            doNotOptimize(ptr);
+        }
+        allocator.clearAll();
+    }
+    report("monotonic_arena/" + name + " PoolAllocator+clearAll", stopwatch.elapsedNs() / (Requests * sizes.size()));
+}
+
+}  // namespace
+
+void run()
+{
+    for (std::size_t objects : {16u, 256u, 4096u})
+    {
+        const auto fixedName = "fixed64 objects=" + std::to_string(objects);
+        const auto fixed = requestSizes(objects, false);
+        mallocFree(fixed, fixedName);
+        pool(fixed, fixedName);
+        arena(fixed, fixedName, false);
+        arena(fixed, fixedName, true);
+
+        const auto mixedName = "mixed16-256 objects=" + std::to_string(objects);
+        const auto mixed = requestSizes(objects, true);
+        mallocFree(mixed, mixedName);
+        arena(mixed, mixedName, false);
+        arena(mixed, mixedName, true);
+    }
+}
+
+}  // namespace bench::monotonic_arena
@@ -0,0 +1,8 @@
+#pragma once
+
+namespace bench::monotonic_arena
+{
+
+void run();
+
+}  // namespace bench::monotonic_arena
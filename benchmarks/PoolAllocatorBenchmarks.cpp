@@ -0,0 +1,150 @@
+#include "PoolAllocatorBenchmarks.hpp"
+#include "Benchmark.hpp"
+
+#include <non_std/PoolAlocator.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace bench::pool_allocator
+{
+
+namespace
+{
+
+template <std::size_t Size>
+struct Payload
+{
+    unsigned char bytes[Size];
+};
+
+// Same shape as HashMap<uint64_t, uint64_t, ...>::Node.
+struct HashMapNode
+{
+    uint64_t key;
+    uint64_t val;
+    HashMapNode* next;
+};
+
+// Resident memory per node, slab headers and chunk headers included, measured over 64 MiB of nodes.
+template <typename T>
+void bytesPerNode(const std::string& name)
+{
+    constexpr std::size_t Nodes = (std::size_t(64) << 20) / sizeof(T);
+    const auto before = residentBytes();
+    PoolAllocator<T> allocator;
+    for (std::size_t i = 0; i < Nodes; ++i)
+    {
+        auto* node = allocator.allocate();
+        std::memset(node, 0xab, sizeof(T));
+    }
+    std::cout << "pool_allocator/bytes_per_node " << name << " sizeof=" << sizeof(T)
+              << " pool_size=" << PoolAllocator<T>::PoolSize
+              << " nodes_per_pool=" << PoolAllocator<T>::NodesPerPool
+              << " resident_bytes_per_node=" << (residentBytes() - before) / Nodes
+              << std::endl;
+}
+
+// Fills `pools` pools, then frees a random half of the slots so that every pool is partly used,
+// which is the shape HashMap churn leaves behind. Measures allocate/dealocate pairs afterwards.
+void allocationLatencyWithLivePools(std::size_t pools)
+{
+    PoolAllocator<uint64_t> allocator;
+    const std::size_t nodes = pools * PoolAllocator<uint64_t>::NodesPerPool;
+    std::vector<uint64_t*> live;
+    live.reserve(nodes);
+    for (std::size_t i = 0; i < nodes; ++i)
+    {
+        live.push_back(allocator.allocate());
+    }
+
+    std::mt19937_64 rng(pools);
+    std::shuffle(live.begin(), live.end(), rng);
+    const auto half = live.size() / 2;
+    for (std::size_t i = half; i < live.size(); ++i)
+    {
+        allocator.dealocate(live[i]);
+    }
+    live.resize(half);
+
+    constexpr std::size_t Batch = 1024;
+    constexpr std::size_t Rounds = 1000;
+    std::vector<uint64_t*> batch(Batch);
+    Stopwatch stopwatch;
+    for (std::size_t round = 0; round < Rounds; ++round)
+    {
+        for (auto& ptr : batch)
+        {
+            ptr = allocator.allocate();
+            doNotOptimize(ptr);
+        }
+        for (auto* ptr : batch)
+        {
+            allocator.dealocate(ptr);
+        }
+    }
+    report("pool_allocator/allocate+dealocate live_pools=" + std::to_string(pools),
+           stopwatch.elapsedNs() / (Batch * Rounds));
+}
+
+// Allocates and frees `batch` nodes per round, either one call per node or one bulk call.
+void batchAllocation(std::size_t batch)
+{
+    constexpr std::size_t NodesPerRound = 1u << 20;
+    const std::size_t rounds = std::max<std::size_t>(NodesPerRound / batch, 1);
+    std::vector<HashMapNode*> ptrs(batch);
+    {
+        PoolAllocator<HashMapNode> allocator;
+        Stopwatch stopwatch;
+        for (std::size_t round = 0; round < rounds; ++round)
+        {
+            for (auto& ptr : ptrs)
+            {
+                ptr = allocator.allocate();
+            }
+            doNotOptimize(ptrs.back());
+            for (auto* ptr : ptrs)
+            {
+                allocator.dealocate(ptr);
+            }
+        }
+        report("pool_allocator/single batch=" + std::to_string(batch), stopwatch.elapsedNs() / (rounds * batch));
+    }
+    {
+        PoolAllocator<HashMapNode> allocator;
+        Stopwatch stopwatch;
+        for (std::size_t round = 0; round < rounds; ++round)
+        {
+            allocator.allocateBulk(batch, ptrs.data());
+            doNotOptimize(ptrs.back());
+            allocator.dealocateBulk(ptrs);
+        }
+        report("pool_allocator/bulk batch=" + std::to_string(batch), stopwatch.elapsedNs() / (rounds * batch));
+    }
+}
+
+}  // namespace
+
+void run()
+{
+    bytesPerNode<uint64_t>("uint64_t");
+    bytesPerNode<HashMapNode>("hash_map_node<uint64_t,uint64_t>");
+    bytesPerNode<Payload<32>>("payload<32>");
+    bytesPerNode<Payload<64>>("payload<64>");
+    bytesPerNode<Payload<256>>("payload<256>");
+
+    for (std::size_t pools : {1u, 10u, 100u, 1000u, 10000u, 100000u})
+    {
+        allocationLatencyWithLivePools(pools);
+    }
+    for (std::size_t batch = 1; batch <= 4096; batch *= 4)
+    {
+        batchAllocation(batch);
+    }
+}
+
+}  // namespace bench::pool_allocator
@@ -0,0 +1,8 @@
+#pragma once
+
+namespace bench::pool_allocator
+{
+
+void run();
+
+}  // namespace bench::pool_allocator
@@ -0,0 +1,122 @@
+#include "ShardedHashMapBenchmarks.hpp"
+#include "Benchmark.hpp"
+
+#include <non_std/containers/HashMap.hpp>
+#include <non_std/containers/threadSafe/ShardedHashMap.hpp>
+
+#include <barrier>
+#include <mutex>
+#include <optional>
+#include <stdint.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace bench::sharded_hash_map
+{
+
+namespace
+{
+
+constexpr uint64_t KeySpace = 1u << 20;
+constexpr std::size_t OpsPerThread = 200000;
+
+struct Sharded
+{
+    static constexpr const char* name = "ShardedHashMap";
+    non_std::containers::thread_safe::ShardedHashMap<uint64_t, uint64_t> map;
+    std::optional<uint64_t> get(uint64_t key) const { return map.get(key); }
+    void store(uint64_t key, uint64_t val) { map.store(key, val); }
+};
+
+// What callers did before: one HashMap behind one mutex.
+struct GlobalMutex
+{
+    static constexpr const char* name = "HashMap+global mutex";
+    mutable std::mutex mutex;
+    non_std::containers::HashMap<uint64_t, uint64_t, 10> map;
+    std::optional<uint64_t> get(uint64_t key) const
+    {
+        std::lock_guard lk(mutex);
+        auto* val = map.get(key);
+        return val != nullptr ? std::optional<uint64_t>(*val) : std::nullopt;
+    }
+    void store(uint64_t key, uint64_t val)
+    {
+        std::lock_guard lk(mutex);
+        map.store(key, val);
+    }
+};
+
+uint64_t xorshift(uint64_t& state)
+{
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+
+template <typename TMap>
+void mixed(TMap& map, unsigned threads, unsigned readPercent)
+{
+    std::barrier sync(threads + 1);
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < threads; ++t)
+    {
+        workers.emplace_back([t, readPercent, &map, &sync]() {
+            uint64_t state = 0x9e3779b97f4a7c15ull * (t + 1);
+            uint64_t sum = 0;
+            sync.arrive_and_wait();
+            for (std::size_t i = 0; i < OpsPerThread; ++i)
+            {
+                auto random = xorshift(state);
+                auto key = random % KeySpace;
+                if ((random >> 32) % 100 < readPercent)
+                {
+                    sum += map.get(key).value_or(0);
+                }
+                else
+                {
+                    map.store(key, random);
+                }
+            }
+            doNotOptimize(sum);
+        });
+    }
+    sync.arrive_and_wait();
+    Stopwatch stopwatch;
+    for (auto& worker : workers)
+    {
+        worker.join();
+    }
+    // Wall time per operation across all threads: lower means more throughput.
+    report(std::string("sharded_hash_map/") + TMap::name + " read=" + std::to_string(readPercent)
+           + " threads=" + std::to_string(threads), stopwatch.elapsedNs() / (OpsPerThread * threads));
+}
+
+template <typename TMap>
+void run()
+{
+    TMap map;
+    for (uint64_t key = 0; key < KeySpace; ++key)
+    {
+        map.store(key, key);
+    }
+    for (unsigned readPercent : {100u, 90u, 50u})
+    {
+        for (unsigned threads : {1u, 2u, 4u, 8u, 16u, 32u, 64u})
+        {
+            mixed(map, threads, readPercent);
+        }
+    }
+}
+
+}  // namespace
+
+void run()
+{
+    run<Sharded>();
+    run<GlobalMutex>();
+}
+
+}  // namespace bench::sharded_hash_map
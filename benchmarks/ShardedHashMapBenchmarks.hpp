@@ -0,0 +1,8 @@
+#pragma once
+
+namespace bench::sharded_hash_map
+{
+
+void run();
+
+}  // namespace bench::sharded_hash_map
@@ -0,0 +1,118 @@
+#include "SharedHashTableWithAgeBenchmarks.hpp"
+#include "Benchmark.hpp"
+
+#include <non_std/containers/FixedSizeHashTableOpenHashingWithAge.hpp>
+#include <non_std/containers/threadSafe/lockFree/SharedHashTableWithAge.hpp>
+
+#include <barrier>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdint.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace bench::shared_hash_table_with_age
+{
+
+namespace
+{
+
+constexpr std::size_t Entries = 1u << 20;
+constexpr uint64_t KeySpace = 1u << 22;
+constexpr std::size_t NodesPerThread = 200000;
+
+struct LockFree
+{
+    static constexpr const char* name = "SharedHashTableWithAge";
+    non_std::containers::thread_safe::lock_free::SharedHashTableWithAge<uint64_t, uint64_t> table{Entries};
+    std::optional<uint64_t> get(uint64_t key) { return table.get(key); }
+    void store(uint64_t key, uint64_t val) { table.store(key, val); }
+};
+
+// What sharing the table took before: the single threaded table behind one mutex.
+struct GlobalMutex
+{
+    static constexpr const char* name = "AgeTable+global mutex";
+    std::mutex mutex;
+    non_std::containers::FixedSizeHashTableOpenHashingWithAge<uint64_t, uint64_t> table{Entries};
+    std::optional<uint64_t> get(uint64_t key)
+    {
+        std::lock_guard lk(mutex);
+        uint64_t* val = table.get(key);
+        return val != nullptr ? std::optional<uint64_t>(*val) : std::nullopt;
+    }
+    void store(uint64_t key, uint64_t val)
+    {
+        std::lock_guard lk(mutex);
+        table.store(key, val);
+    }
+};
+
+uint64_t xorshift(uint64_t& state)
+{
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+
+// A search node: probe the table, store the result on a miss.
+template <typename TTable>
+void nodes(TTable& table, unsigned threads)
+{
+    std::barrier sync(threads + 1);
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < threads; ++t)
+    {
+        workers.emplace_back([t, &table, &sync]() {
+            uint64_t state = 0x9e3779b97f4a7c15ull * (t + 1);
+            uint64_t sum = 0;
+            sync.arrive_and_wait();
+            for (std::size_t i = 0; i < NodesPerThread; ++i)
+            {
+                auto random = xorshift(state);
+                auto key = random % KeySpace;
+                if (auto val = table.get(key))
+                {
+                    sum += *val;
+                }
+                else
+                {
+                    table.store(key, random);
+                }
+            }
+            doNotOptimize(sum);
+        });
+    }
+    sync.arrive_and_wait();
+    Stopwatch stopwatch;
+    for (auto& worker : workers)
+    {
+        worker.join();
+    }
+    // Wall time per node across all threads: lower means more throughput.
+    report(std::string("shared_hash_table_with_age/") + TTable::name + " threads=" + std::to_string(threads),
+           stopwatch.elapsedNs() / (NodesPerThread * threads));
+}
+
+template <typename TTable>
+void run()
+{
+    auto table = std::make_unique<TTable>();
+    for (unsigned threads : {1u, 2u, 4u, 8u, 16u, 32u, 64u})
+    {
+        nodes(*table, threads);
+    }
+}
+
+}  // namespace
+
+void run()
+{
+    run<LockFree>();
+    run<GlobalMutex>();
+}
+
+}  // namespace bench::shared_hash_table_with_age
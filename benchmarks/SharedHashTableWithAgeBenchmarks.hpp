@@ -0,0 +1,8 @@
+#pragma once
+
+namespace bench::shared_hash_table_with_age
+{
+
+void run();
+
+}  // namespace bench::shared_hash_table_with_age
@@ -0,0 +1,100 @@
+#include "StdAllocatorBenchmarks.hpp"
+#include "Benchmark.hpp"
+
+#include <non_std/PoolMemoryResource.hpp>
+
+#include <list>
+#include <map>
+#include <memory_resource>
+#include <random>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace bench::std_allocator
+{
+
+namespace
+{
+
+constexpr std::size_t Elements = 1u << 16;
+constexpr std::size_t Rounds = 20;
+
+std::vector<uint64_t> shuffledKeys()
+{
+    std::vector<uint64_t> keys(Elements);
+    std::mt19937_64 rng(42);
+    for (auto& key : keys)
+    {
+        key = rng();
+    }
+    return keys;
+}
+
+// Inserts every key, then erases them all, Rounds times over the same container.
+template <typename TMap>
+void mapInsertErase(const std::string& name, TMap map)
+{
+    const auto keys = shuffledKeys();
+    Stopwatch stopwatch;
+    for (std::size_t round = 0; round < Rounds; ++round)
+    {
+        for (auto key : keys)
+        {
+            map.emplace(key, key);
+        }
+        for (auto key : keys)
+        {
+            map.erase(key);
+        }
+    }
+    doNotOptimize(map.size());
+    report("std_allocator/map insert+erase " + name, stopwatch.elapsedNs() / (Rounds * Elements));
+}
+
+// Pushes every element, then pops from the front, Rounds times over the same container.
+template <typename TList>
+void listPushPop(const std::string& name, TList list)
+{
+    Stopwatch stopwatch;
+    for (std::size_t round = 0; round < Rounds; ++round)
+    {
+        for (std::size_t i = 0; i < Elements; ++i)
+        {
+            list.push_back(i);
+        }
+        while (!list.empty())
+        {
+            list.pop_front();
+        }
+    }
+    doNotOptimize(list.size());
+    report("std_allocator/list push+pop " + name, stopwatch.elapsedNs() / (Rounds * Elements));
+}
+
+}  // namespace
+
+void run()
+{
+    using Pair = std::pair<const uint64_t, uint64_t>;
+    {
+        mapInsertErase("std::allocator", std::map<uint64_t, uint64_t>());
+        PoolMemoryResource resource;
+        mapInsertErase("PoolStdAllocator",
+            std::map<uint64_t, uint64_t, std::less<uint64_t>, PoolStdAllocator<Pair>>(PoolStdAllocator<Pair>(&resource)));
+        mapInsertErase("pmr+PoolMemoryResource", std::pmr::map<uint64_t, uint64_t>(&resource));
+        std::pmr::unsynchronized_pool_resource stdPool;
+        mapInsertErase("pmr+unsynchronized_pool_resource", std::pmr::map<uint64_t, uint64_t>(&stdPool));
+    }
+    {
+        listPushPop("std::allocator", std::list<uint64_t>());
+        PoolMemoryResource resource;
+        listPushPop("PoolStdAllocator",
+            std::list<uint64_t, PoolStdAllocator<uint64_t>>(PoolStdAllocator<uint64_t>(&resource)));
+        listPushPop("pmr+PoolMemoryResource", std::pmr::list<uint64_t>(&resource));
+        std::pmr::unsynchronized_pool_resource stdPool;
+        listPushPop("pmr+unsynchronized_pool_resource", std::pmr::list<uint64_t>(&stdPool));
+    }
+}
+
+}  // namespace bench::std_allocator
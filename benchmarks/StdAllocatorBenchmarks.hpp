@@ -0,0 +1,8 @@
+#pragma once
+
+namespace bench::std_allocator
+{
+
+void run();
+
+}  // namespace bench::std_allocator
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <stdint.h>
+#include <vector>
+
+#include <non_std/containers/Hash.hpp>
+
+namespace bench
+{
+
+// count keys drawn from 0..universe-1 with P(rank k) ~ 1 / (k + 1)^skew, each rank scrambled to a
+// 64-bit key so popular keys are not neighbours. Sampled by inverting the CDF, outside any timing.
+inline std::vector<uint64_t> zipfTrace(std::size_t universe, std::size_t count, double skew, uint64_t seed)
+{
+    std::vector<double> cdf(universe);
+    double sum = 0;
+    for (std::size_t rank = 0; rank < universe; ++rank)
+    {
+        sum += 1.0 / std::pow(double(rank + 1), skew);
+        cdf[rank] = sum;
+    }
+    std::mt19937_64 rng(seed);
+    std::uniform_real_distribution<double> uniform(0, sum);
+    std::vector<uint64_t> trace(count);
+    for (auto& key : trace)
+    {
+        auto rank = std::lower_bound(cdf.begin(), cdf.end(), uniform(rng)) - cdf.begin();
+        key = non_std::containers::mix64(uint64_t(std::min<std::size_t>(rank, universe - 1)) + 1);
+    }
+    return trace;
+}
+
+}  // namespace bench
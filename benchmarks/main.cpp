@@ -0,0 +1,35 @@
+#include "PoolAllocatorBenchmarks.hpp"
+#include "ConcurrentPoolAllocatorBenchmarks.hpp"
+#include "StdAllocatorBenchmarks.hpp"
+#include "MonotonicArenaBenchmarks.hpp"
+#include "HashMapBenchmarks.hpp"
+#include "FlatHashMapBenchmarks.hpp"
+#include "ShardedHashMapBenchmarks.hpp"
+#include "LargeValueBenchmarks.hpp"
+#include "FrozenHashMapBenchmarks.hpp"
+#include "LruCacheBenchmarks.hpp"
+#include "SharedHashTableWithAgeBenchmarks.hpp"
+#include "AgeTableBenchmarks.hpp"
+
+#include <string>
+
+/* Usage: nonStdBench [filter] - runs every benchmark group whose name contains filter. */
+int main(int argc, char** argv)
+{
+    const std::string filter = argc > 1 ? argv[1] : "";
+    auto selected = [&filter](const std::string& name) { return name.find(filter) != std::string::npos; };
+
+    if (selected("pool_allocator")) bench::pool_allocator::run();
+    if (selected("concurrent_pool_allocator")) bench::concurrent_pool_allocator::run();
+    if (selected("std_allocator")) bench::std_allocator::run();
+    if (selected("monotonic_arena")) bench::monotonic_arena::run();
+    if (selected("hash_map")) bench::hash_map::run();
+    if (selected("flat_hash_map")) bench::flat_hash_map::run();
+    if (selected("sharded_hash_map")) bench::sharded_hash_map::run();
+    if (selected("large_value")) bench::large_value::run();
+    if (selected("frozen_hash_map")) bench::frozen_hash_map::run();
+    if (selected("lru_cache")) bench::lru_cache::run();
+    if (selected("shared_hash_table_with_age")) bench::shared_hash_table_with_age::run();
+    if (selected("age_table")) bench::age_table::run();
+    return 0;
+}
@@ -1,9 +1,27 @@
 // #include "tests/lockFreeQueuesTests.hpp"
 #include "tests/FixedSizeHashTableOpenHashingWIthAgeTests.hpp"
+#include "tests/PoolAllocatorTests.hpp"
+#include "tests/ConcurrentPoolAllocatorTests.hpp"
+#include "tests/MonotonicArenaTests.hpp"
+#include "tests/HashMapTests.hpp"
+#include "tests/FlatHashMapTests.hpp"
+#include "tests/ShardedHashMapTests.hpp"
+#include "tests/FrozenHashMapTests.hpp"
+#include "tests/LruCacheTests.hpp"
+#include "tests/SharedHashTableWithAgeTests.hpp"
 int main()
 {
     // gcc linker errors
     // test::lock_free_structures::test();
     test::fixed_size_hash_table_open_hashing_with_age::test();
+    test::pool_allocator::test();
+    test::concurrent_pool_allocator::test();
+    test::monotonic_arena::test();
+    test::hash_map::test();
+    test::flat_hash_map::test();
+    test::sharded_hash_map::test();
+    test::frozen_hash_map::test();
+    test::lru_cache::test();
+    test::shared_hash_table_with_age::test();
     return 0;
 }
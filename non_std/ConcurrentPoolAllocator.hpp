@@ -0,0 +1,322 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <stdint.h>
+
+#include <non_std/internal/PageAllocation.hpp>
+
+/*
+Some assumptions:
+1. Thread safe. Every ConcurrentPoolAllocator<T> shares one per-T depot, so a node allocated through
+   one instance may be freed through any other instance, from any thread.
+2. Does not perform object construction/deletion. It just allocates the memory.
+3. Slabs are never returned to the system; they are freed when the process exits.
+4. Each thread owns a magazine (free list) fed from slabs it carved. Freeing a node owned by another
+   thread buffers it and hands it back to the owner in batches of BatchSize with a single CAS.
+5. Fresh slabs come from a lock-free central depot. When it is empty, a thread takes a whole ChunkSize
+   chunk with allocatePages(), keeps its first slab and hands the others to the depot, so slabs
+   cost no alignment padding of their own.
+6. A thread cache outlives its thread: it is parked on exit and adopted by the next new thread, so
+   nodes freed to an exited owner are not lost.
+*/
+template <typename T>
+class ConcurrentPoolAllocator
+{
+private:
+    struct FreeNode
+    {
+        FreeNode* next;
+    };
+
+    struct ThreadCache;
+
+    struct Slab
+    {
+        ThreadCache* owner = nullptr;
+        std::atomic<Slab*> nextInDepot = nullptr;
+        // Links the first slabs of the chunks.
+        Slab* nextChunk = nullptr;
+    };
+
+    static constexpr std::size_t NodeAlign = std::max(alignof(T), alignof(FreeNode));
+    static constexpr std::size_t NodeSize = (std::max(sizeof(T), sizeof(FreeNode)) + NodeAlign - 1) / NodeAlign * NodeAlign;
+    static constexpr std::size_t NodesOffset = (sizeof(Slab) + NodeAlign - 1) / NodeAlign * NodeAlign;
+public:
+    static constexpr std::size_t SlabSize = std::bit_floor(NodesOffset + 256 * NodeSize);
+    static constexpr std::size_t NodesPerSlab = (SlabSize - NodesOffset) / NodeSize;
+    static constexpr unsigned BatchSize = 64;
+    static constexpr std::size_t ChunkSize = std::max(non_std::internal::HugePageSize, 4 * SlabSize);
+private:
+    static constexpr std::size_t SlabsPerChunk = ChunkSize / SlabSize;
+    static constexpr unsigned PendingOwners = 4;
+
+    struct RemoteBatch
+    {
+        ThreadCache* owner = nullptr;
+        FreeNode* head = nullptr;
+        FreeNode* tail = nullptr;
+        unsigned count = 0;
+    };
+
+    struct ThreadCache
+    {
+        // Touched only by the thread which currently holds the cache.
+        FreeNode* magazine = nullptr;
+        RemoteBatch pending[PendingOwners];
+        // Batches of nodes freed by other threads.
+        std::atomic<FreeNode*> inbox = nullptr;
+        std::atomic<bool> inUse = true;
+        ThreadCache* nextCache = nullptr;
+    };
+
+    struct Depot
+    {
+        // Treiber stack of free slabs. Slabs are SlabSize-aligned, so the low bits hold an ABA tag.
+        std::atomic<uintptr_t> freeSlabs = 0;
+        std::atomic<Slab*> chunks = nullptr;
+        std::atomic<ThreadCache*> caches = nullptr;
+
+        ~Depot()
+        {
+            for (auto* chunk = chunks.load(); chunk != nullptr;)
+            {
+                auto* next = chunk->nextChunk;
+                for (std::size_t i = 0; i < SlabsPerChunk; ++i)
+                {
+                    std::destroy_at(slabAt(chunk, i));
+                }
+                non_std::internal::freePages(chunk, ChunkSize, {}, ChunkSize);
+                chunk = next;
+            }
+            for (auto* cache = caches.load(); cache != nullptr;)
+            {
+                auto* next = cache->nextCache;
+                delete cache;
+                cache = next;
+            }
+        }
+    };
+
+    struct CacheHandle
+    {
+        ThreadCache* cache = nullptr;
+
+        ~CacheHandle()
+        {
+            if (cache != nullptr)
+            {
+                releaseCache(cache);
+                cache = nullptr;
+            }
+        }
+    };
+
+public:
+    using value_type = T;
+
+    ConcurrentPoolAllocator() noexcept = default;
+
+    T* allocate()
+    {
+        ThreadCache* cache = localCache();
+        if (cache->magazine == nullptr)
+        {
+            refill(cache);
+        }
+        FreeNode* node = cache->magazine;
+        cache->magazine = node->next;
+        return reinterpret_cast<T*>(node);
+    }
+
+    void dealocate(T* in)
+    {
+        ThreadCache* cache = localCache();
+        auto* node = reinterpret_cast<FreeNode*>(in);
+        ThreadCache* owner = slabOf(in)->owner;
+        if (owner == cache)
+        {
+            node->next = cache->magazine;
+            cache->magazine = node;
+            return;
+        }
+
+        RemoteBatch& batch = cache->pending[(reinterpret_cast<uintptr_t>(owner) / alignof(ThreadCache)) % PendingOwners];
+        if (batch.owner != owner)
+        {
+            flush(batch);
+            batch.owner = owner;
+        }
+        node->next = batch.head;
+        if (batch.head == nullptr)
+        {
+            batch.tail = node;
+        }
+        batch.head = node;
+        if (++batch.count == BatchSize)
+        {
+            flush(batch);
+        }
+    }
+
+    // Hands every node this thread freed on behalf of other threads back to its owner now.
+    void flushRemoteFrees()
+    {
+        ThreadCache* cache = localCache();
+        for (auto& batch : cache->pending)
+        {
+            flush(batch);
+        }
+    }
+
+private:
+    static Depot& depot()
+    {
+        static Depot instance;
+        return instance;
+    }
+
+    static ThreadCache* localCache()
+    {
+        thread_local CacheHandle handle;
+        if (handle.cache == nullptr)
+        {
+            handle.cache = acquireCache();
+        }
+        return handle.cache;
+    }
+
+    static ThreadCache* acquireCache()
+    {
+        Depot& shared = depot();
+        for (auto* cache = shared.caches.load(std::memory_order_acquire); cache != nullptr; cache = cache->nextCache)
+        {
+            bool expected = false;
+            if (cache->inUse.compare_exchange_strong(expected, true, std::memory_order_acquire))
+            {
+                return cache;
+            }
+        }
+        auto* cache = new ThreadCache();
+        cache->nextCache = shared.caches.load(std::memory_order_relaxed);
+        while (!shared.caches.compare_exchange_weak(cache->nextCache, cache, std::memory_order_release));
+        return cache;
+    }
+
+    static void releaseCache(ThreadCache* cache)
+    {
+        for (auto& batch : cache->pending)
+        {
+            flush(batch);
+        }
+        cache->inUse.store(false, std::memory_order_release);
+    }
+
+    static void flush(RemoteBatch& batch)
+    {
+        if (batch.head != nullptr)
+        {
+            auto& inbox = batch.owner->inbox;
+            batch.tail->next = inbox.load(std::memory_order_relaxed);
+            while (!inbox.compare_exchange_weak(batch.tail->next, batch.head,
+                std::memory_order_release, std::memory_order_relaxed));
+        }
+        batch = RemoteBatch{};
+    }
+
+    static void refill(ThreadCache* cache)
+    {
+        cache->magazine = cache->inbox.exchange(nullptr, std::memory_order_acquire);
+        if (cache->magazine != nullptr)
+        {
+            return;
+        }
+        for (auto& batch : cache->pending)
+        {
+            flush(batch);
+        }
+
+        Slab* slab = popSlab();
+        if (slab == nullptr)
+        {
+            slab = createChunk();
+        }
+        slab->owner = cache;
+
+        auto* first = reinterpret_cast<unsigned char*>(slab) + NodesOffset;
+        for (std::size_t i = NodesPerSlab; i-- > 0;)
+        {
+            auto* node = reinterpret_cast<FreeNode*>(first + i * NodeSize);
+            node->next = cache->magazine;
+            cache->magazine = node;
+        }
+    }
+
+    // Returns the first slab of a new chunk; the others go to the depot.
+    static Slab* createChunk()
+    {
+        auto* chunk = non_std::internal::allocatePages(ChunkSize, {}, ChunkSize, false);
+        for (std::size_t i = 0; i < SlabsPerChunk; ++i)
+        {
+            std::construct_at(slabAt(chunk, i));
+        }
+        auto* first = slabAt(chunk, 0);
+        Depot& shared = depot();
+        first->nextChunk = shared.chunks.load(std::memory_order_relaxed);
+        while (!shared.chunks.compare_exchange_weak(first->nextChunk, first, std::memory_order_relaxed));
+        for (std::size_t i = 1; i < SlabsPerChunk; ++i)
+        {
+            pushSlab(slabAt(chunk, i));
+        }
+        return first;
+    }
+
+    static Slab* slabAt(void* chunk, std::size_t index)
+    {
+        return reinterpret_cast<Slab*>(static_cast<unsigned char*>(chunk) + index * SlabSize);
+    }
+
+    static constexpr uintptr_t TagMask = SlabSize - 1;
+
+    static void pushSlab(Slab* slab)
+    {
+        auto& head = depot().freeSlabs;
+        uintptr_t oldHead = head.load(std::memory_order_relaxed);
+        uintptr_t newHead;
+        do
+        {
+            slab->nextInDepot.store(reinterpret_cast<Slab*>(oldHead & ~TagMask), std::memory_order_relaxed);
+            newHead = reinterpret_cast<uintptr_t>(slab) | ((oldHead + 1) & TagMask);
+        } while (!head.compare_exchange_weak(oldHead, newHead, std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    static Slab* popSlab()
+    {
+        auto& head = depot().freeSlabs;
+        uintptr_t oldHead = head.load(std::memory_order_acquire);
+        while (true)
+        {
+            auto* slab = reinterpret_cast<Slab*>(oldHead & ~TagMask);
+            if (slab == nullptr)
+            {
+                return nullptr;
+            }
+            // Slabs are never freed, so reading a stale next is safe; the tag makes the CAS fail then.
+            auto next = reinterpret_cast<uintptr_t>(slab->nextInDepot.load(std::memory_order_relaxed));
+            if (head.compare_exchange_weak(oldHead, next | ((oldHead + 1) & TagMask),
+                std::memory_order_acquire, std::memory_order_acquire))
+            {
+                return slab;
+            }
+        }
+    }
+
+    static Slab* slabOf(T* in)
+    {
+        return reinterpret_cast<Slab*>(reinterpret_cast<uintptr_t>(in) & ~uintptr_t(SlabSize - 1));
+    }
+};
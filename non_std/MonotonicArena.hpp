@@ -0,0 +1,181 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <new>
+#include <stdint.h>
+
+#include <non_std/internal/PageAllocation.hpp>
+
+/*
+Bump pointer arena for short living data of mixed sizes (per request, per search node).
+Some assumptions:
+1. Not thread safe.
+2. Does not perform object construction/deletion. It just allocates the memory.
+3. There is no per object free. rewind(checkpoint) frees everything allocated after the checkpoint
+   and reset() frees everything, both in O(1).
+4. Chunks are kept after rewind()/reset() and reused; releaseUnusedChunks() gives them back.
+5. With hugePages, chunks are HugePageSize multiples mapped with MADV_HUGEPAGE (Linux only).
+*/
+class MonotonicArena
+{
+private:
+    struct Chunk
+    {
+        Chunk* next;
+        std::size_t size;
+    };
+    static constexpr std::size_t ChunkHeader = (sizeof(Chunk) + alignof(std::max_align_t) - 1)
+        / alignof(std::max_align_t) * alignof(std::max_align_t);
+
+public:
+    static constexpr std::size_t DefaultChunkSize = 64 * 1024;
+
+    struct Checkpoint
+    {
+        Chunk* chunk = nullptr;
+        std::size_t offset = ChunkHeader;
+    };
+
+    explicit MonotonicArena(std::size_t chunkSize = DefaultChunkSize, bool hugePages = false) noexcept
+        : chunkSize_(hugePages ? roundUp(chunkSize, non_std::internal::HugePageSize) : chunkSize)
+        , hugePages_(hugePages)
+    {
+    }
+
+    MonotonicArena(const MonotonicArena&) = delete;
+    MonotonicArena& operator=(const MonotonicArena&) = delete;
+
+    ~MonotonicArena()
+    {
+        freeChunks(head_);
+    }
+
+    void* allocate(std::size_t bytes, std::size_t alignment = alignof(std::max_align_t))
+    {
+        if (current_ != nullptr)
+        {
+            auto offset = alignedOffset(current_, offset_, alignment);
+            if (offset + bytes <= current_->size)
+            {
+                offset_ = offset + bytes;
+                return reinterpret_cast<unsigned char*>(current_) + offset;
+            }
+        }
+        return allocateFromNextChunk(bytes, alignment);
+    }
+
+    template <typename T>
+    T* allocate(std::size_t count = 1)
+    {
+        return static_cast<T*>(allocate(count * sizeof(T), alignof(T)));
+    }
+
+    Checkpoint checkpoint() const noexcept
+    {
+        return Checkpoint{current_, offset_};
+    }
+
+    // Everything allocated after checkpoint was taken is freed. Later checkpoints become invalid.
+    void rewind(Checkpoint checkpoint) noexcept
+    {
+        current_ = checkpoint.chunk;
+        offset_ = checkpoint.offset;
+    }
+
+    void reset() noexcept
+    {
+        rewind(Checkpoint{});
+    }
+
+    // Releases chunks which are not used since the last rewind()/reset().
+    void releaseUnusedChunks()
+    {
+        if (current_ == nullptr)
+        {
+            freeChunks(head_);
+            head_ = nullptr;
+            return;
+        }
+        freeChunks(current_->next);
+        current_->next = nullptr;
+    }
+
+    std::size_t bytesReserved() const noexcept
+    {
+        std::size_t out = 0;
+        for (auto* chunk = head_; chunk != nullptr; chunk = chunk->next)
+        {
+            out += chunk->size;
+        }
+        return out;
+    }
+
+private:
+    static std::size_t roundUp(std::size_t value, std::size_t alignment)
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    static std::size_t alignedOffset(Chunk* chunk, std::size_t offset, std::size_t alignment)
+    {
+        auto address = reinterpret_cast<uintptr_t>(chunk) + offset;
+        return offset + (roundUp(address, alignment) - address);
+    }
+
+    void* allocateFromNextChunk(std::size_t bytes, std::size_t alignment)
+    {
+        // Chunks after current_ are free since the last rewind; take the next one if it fits.
+        Chunk* next = current_ != nullptr ? current_->next : head_;
+        if (next == nullptr || alignedOffset(next, ChunkHeader, alignment) + bytes > next->size)
+        {
+            auto size = std::max(chunkSize_, ChunkHeader + bytes + alignment);
+            next = createChunk(hugePages_ ? roundUp(size, non_std::internal::HugePageSize) : size);
+            if (current_ != nullptr)
+            {
+                next->next = current_->next;
+                current_->next = next;
+            }
+            else
+            {
+                next->next = head_;
+                head_ = next;
+            }
+        }
+        current_ = next;
+        auto offset = alignedOffset(current_, ChunkHeader, alignment);
+        offset_ = offset + bytes;
+        return reinterpret_cast<unsigned char*>(current_) + offset;
+    }
+
+    Chunk* createChunk(std::size_t size)
+    {
+        void* memory = hugePages_
+            ? non_std::internal::allocatePages(size, true)
+            : ::operator new(size, std::align_val_t(alignof(std::max_align_t)));
+        return new (memory) Chunk{nullptr, size};
+    }
+
+    void freeChunks(Chunk* chunk)
+    {
+        while (chunk != nullptr)
+        {
+            auto* next = chunk->next;
+            if (hugePages_)
+            {
+                non_std::internal::freePages(chunk, chunk->size, true);
+            }
+            else
+            {
+                ::operator delete(chunk, std::align_val_t(alignof(std::max_align_t)));
+            }
+            chunk = next;
+        }
+    }
+
+    Chunk* head_ = nullptr;
+    Chunk* current_ = nullptr;
+    std::size_t offset_ = ChunkHeader;
+    std::size_t chunkSize_;
+    bool hugePages_;
+};
@@ -1,146 +1,626 @@
 #pragma once
 
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <new>
+#include <span>
 #include <stdint.h>
+#include <utility>
 
 #include <non_std/BitOperations/Intrincts.hpp>
+#include <non_std/internal/PageAllocation.hpp>
+
+struct PoolAllocatorStats
+{
+    std::size_t liveObjects = 0;
+    std::size_t pools = 0;
+    std::size_t bytesReserved = 0;
+    std::size_t bytesInUse = 0;
+    // Slab chunks held from the system, holes of released slabs included.
+    std::size_t bytesMapped = 0;
+};
+
+/*
+Once more than highWaterMark pools are completely free, free pools are released to the system until
+lowWaterMark of them are left. The gap between the two marks keeps alloc/free churn around a pool
+boundary from repeatedly releasing and creating the same pool. Default never releases anything.
+*/
+struct PoolAllocatorTrimPolicy
+{
+    std::size_t highWaterMark = std::numeric_limits<std::size_t>::max();
+    std::size_t lowWaterMark = 0;
+};
 
 /*
 Some assumptions:
 1. Not thread safe.
 2. Does not perform object construction/deletion. It just allocates the memory.
-3. Does not free memory until destructor is called.
+3. Does not free memory until destructor is called, unless PoolAllocatorTrimPolicy says so.
+4. allocate() and dealocate() are O(1): every pool keeps a summary word telling which
+   allocationMask words still have free slots and availablePools_ head is never full.
+5. Pools are PoolSize-aligned slabs: pool header followed by nodes. dealocate() finds the owning
+   pool by masking the address, so a node takes exactly sizeof(T) bytes.
+6. Partly used pools are preferred over completely free ones, so free pools can be trimmed.
+7. allocateBulk()/dealocateBulk() claim and release whole allocationMask words and move a pool
+   between lists at most once per batch.
+8. forEachAllocated() visits live nodes slab by slab, reading only the masks of pools which have live
+   nodes. Slabs come in list order; only the nodes within one slab are in address order.
+9. Slabs are cut from chunks taken with allocatePages(), not zero filled, placed as the PagePolicy
+   asks. Chunks start at MinChunkSize and double with the slabs held, up to MaxChunkSize (every
+   chunk is MaxChunkSize with huge pages). A released slab leaves a hole which its chunk hands out
+   before carving new slabs. Pages of holes go back to the system (a page of small slabs once all
+   of them are released), and a chunk goes back when its last slab is released.
 */
 template <typename T>
 struct PoolAllocator
 {
 private:
+    struct SlabChunk;
+
     struct AllocationPool
     {
-        uint64_t allocationMask[4] = {0xffffffffffffffff, 0xffffffffffffffff, 0xffffffffffffffff, 0xffffffffffffffff};
+        uint64_t allocationMask[4];
+        // Bit i is set when allocationMask[i] has at least one free slot.
+        uint32_t summary;
+        uint32_t liveNodes;
+        SlabChunk* chunk;
         AllocationPool* prev = nullptr;
         AllocationPool* next = nullptr;
+    };
 
-        struct Node
-        {
-            unsigned char payload_[sizeof(T)];
-            AllocationPool* poolParrent_;
-        } nodes_[256];
-        using ptr_type = Node*;
+    static constexpr std::size_t NodesOffset = (sizeof(AllocationPool) + alignof(T) - 1) / alignof(T) * alignof(T);
+public:
+    // Largest power of two not above the space needed for 256 nodes, so at most one node worth of
+    // memory is wasted per slab.
+    static constexpr std::size_t PoolSize = std::bit_floor(NodesOffset + 256 * sizeof(T));
+    static constexpr std::size_t NodesPerPool = std::min<std::size_t>(256, (PoolSize - NodesOffset) / sizeof(T));
+private:
+    static_assert(NodesPerPool > 0 && PoolSize >= alignof(T));
+
+    static constexpr uint64_t initialMask(unsigned wordIndex)
+    {
+        if (NodesPerPool >= (wordIndex + 1) * 64) return 0xffffffffffffffffull;
+        if (NodesPerPool <= wordIndex * 64) return 0x0;
+        return (1ull << (NodesPerPool - wordIndex * 64)) - 1;
+    }
+    static constexpr uint64_t initialSummary = (initialMask(0) != 0) | ((initialMask(1) != 0) << 1)
+        | ((initialMask(2) != 0) << 2) | ((initialMask(3) != 0) << 3);
+
+    struct SlabChunk
+    {
+        unsigned char* base = nullptr;
+        std::size_t slabs = 0;
+        // Slabs below carved were handed out at least once; holes of them are released now.
+        std::size_t carved = 0;
+        std::size_t holes = 0;
+        std::size_t live = 0;
+        // Bit per slab, set for holes.
+        std::unique_ptr<uint64_t[]> released;
+        // Links chunks which have a hole or slabs left to carve.
+        SlabChunk* prev = nullptr;
+        SlabChunk* next = nullptr;
     };
+public:
+    static constexpr std::size_t MinChunkSize = std::max(PoolSize, non_std::internal::PageSize);
+    static constexpr std::size_t MaxChunkSize = std::max(PoolSize, non_std::internal::HugePageSize);
+private:
+    static constexpr std::size_t SlabsPerPage = std::max<std::size_t>(non_std::internal::PageSize / PoolSize, 1);
+
     AllocationPool* availablePools_ = nullptr;
+    AllocationPool* emptyPools_ = nullptr;
     AllocationPool* fullyAllocatedPools_ = nullptr;
+    std::size_t pools_ = 0;
+    std::size_t emptyPoolsCount_ = 0;
+    std::size_t liveObjects_ = 0;
+    PoolAllocatorTrimPolicy trimPolicy_;
+    non_std::internal::PagePolicy pages_;
+    SlabChunk* chunksWithRoom_ = nullptr;
+    std::size_t chunkSlabs_ = 0;
 public:
     using value_type = T;
 
     PoolAllocator() noexcept = default;
 
-    T* allocate()
+    explicit PoolAllocator(PoolAllocatorTrimPolicy trimPolicy) noexcept
+        : trimPolicy_(trimPolicy)
     {
-        if (availablePools_ == nullptr)
+    }
+
+    PoolAllocator(PoolAllocatorTrimPolicy trimPolicy, const non_std::internal::PagePolicy& pages) noexcept
+        : trimPolicy_(trimPolicy)
+        , pages_(pages)
+    {
+    }
+
+    PoolAllocator(const PoolAllocator&) = delete;
+    PoolAllocator& operator=(const PoolAllocator&) = delete;
+
+    PoolAllocator(PoolAllocator&& other) noexcept
+    {
+        swap(other);
+    }
+
+    PoolAllocator& operator=(PoolAllocator&& other) noexcept
+    {
+        if (this != &other)
         {
-            availablePools_ = new AllocationPool();
+            PoolAllocator(std::move(other)).swap(*this);
         }
-        for (AllocationPool* current = availablePools_; current != nullptr; current = current->next)
-        {
-            for (auto i = 0; i < 4; ++i)
-            {
-                if (current->allocationMask[i] != 0x0)
-                {
-                    unsigned char freeBit = bit_operations::intrincs::findFirstSet(current->allocationMask[i]) - 1;
-                    current->allocationMask[i] ^= (1ull <<freeBit);
+        return *this;
+    }
+
+    void swap(PoolAllocator& other) noexcept
+    {
+        std::swap(availablePools_, other.availablePools_);
+        std::swap(emptyPools_, other.emptyPools_);
+        std::swap(fullyAllocatedPools_, other.fullyAllocatedPools_);
+        std::swap(pools_, other.pools_);
+        std::swap(emptyPoolsCount_, other.emptyPoolsCount_);
+        std::swap(liveObjects_, other.liveObjects_);
+        std::swap(trimPolicy_, other.trimPolicy_);
+        std::swap(pages_, other.pages_);
+        std::swap(chunksWithRoom_, other.chunksWithRoom_);
+        std::swap(chunkSlabs_, other.chunkSlabs_);
+    }
 
-                    auto freeField = i * 64 + freeBit;
-                    current->nodes_[freeField].poolParrent_ = current;
+    T* allocate()
+    {
+        AllocationPool* current = availablePool();
 
-                    if (isFull(current))
-                    {
-                        moveTofullyAllocated(current);
-                    }
-                    return (T*)(&(current->nodes_[freeField]));
-                }
+        unsigned char wordIndex = bit_operations::intrincs::findFirstSet(current->summary) - 1;
+        uint64_t& word = current->allocationMask[wordIndex];
+        unsigned char freeBit = bit_operations::intrincs::findFirstSet(word) - 1;
+        word ^= (1ull << freeBit);
+        ++current->liveNodes;
+        ++liveObjects_;
+        if (word == 0x0)
+        {
+            current->summary ^= (1ull << wordIndex);
+            if (isFull(current))
+            {
+                moveTofullyAllocated(current);
             }
         }
-        return nullptr;
+
+        return nodeAt(current, wordIndex * 64 + freeBit);
     }
+
     void dealocate(T* in)
     {
-        AllocationPool* toBeRemoved = (((typename AllocationPool::ptr_type)(in))->poolParrent_);
+        AllocationPool* toBeRemoved = poolOf(in);
         if (isFull(toBeRemoved))
         {
             moveToAvaiable(toBeRemoved);
         }
-        unsigned index = ((typename AllocationPool::ptr_type)(in)) - toBeRemoved->nodes_;
+        unsigned index = indexOf(toBeRemoved, in);
         auto wordIndex = (index >> 6);
         auto bit = index & 0b111111;
 
         toBeRemoved->allocationMask[wordIndex] ^= (1ull << bit);
+        toBeRemoved->summary |= (1ull << wordIndex);
+        --liveObjects_;
+        if (--toBeRemoved->liveNodes == 0)
+        {
+            move(availablePools_, emptyPools_, toBeRemoved);
+            ++emptyPoolsCount_;
+            trimIfNeeded();
+        }
     }
-/*
-    void clearAll()
+
+    // Writes n node pointers to out.
+    void allocateBulk(std::size_t n, T** out)
     {
-        deleteNext(availablePools_);
-        deleteNext(fullyAllocatedPools_);
-        availablePools_ = nullptr;
-        fullyAllocatedPools_ = nullptr;
+        if (n == 1)
+        {
+            *out = allocate();
+            return;
+        }
+        while (n > 0)
+        {
+            AllocationPool* current = availablePool();
+            std::size_t claimed = 0;
+            while (n > 0 && current->summary != 0x0)
+            {
+                unsigned char wordIndex = bit_operations::intrincs::findFirstSet(current->summary) - 1;
+                uint64_t& word = current->allocationMask[wordIndex];
+                uint64_t toClaim = word;
+                if (std::size_t(std::popcount(word)) > n)
+                {
+                    // Keep only the n lowest free slots.
+                    uint64_t rest = word;
+                    for (std::size_t i = 0; i < n; ++i)
+                    {
+                        rest &= rest - 1;
+                    }
+                    toClaim ^= rest;
+                }
+                word ^= toClaim;
+                if (word == 0x0)
+                {
+                    current->summary ^= (1ull << wordIndex);
+                }
+
+                auto count = std::popcount(toClaim);
+                claimed += count;
+                n -= count;
+                while (toClaim != 0x0)
+                {
+                    unsigned char bit = bit_operations::intrincs::findFirstSet(toClaim) - 1;
+                    toClaim &= toClaim - 1;
+                    *out++ = nodeAt(current, wordIndex * 64 + bit);
+                }
+            }
+            current->liveNodes += claimed;
+            liveObjects_ += claimed;
+            if (isFull(current))
+            {
+                moveTofullyAllocated(current);
+            }
+        }
     }
-*/
+
+    // Nodes freed together should come from few pools (e.g. allocated by one allocateBulk call):
+    // consecutive nodes from the same pool are released as whole mask words.
+    void dealocateBulk(std::span<T* const> nodes)
+    {
+        if (nodes.size() == 1)
+        {
+            dealocate(nodes.front());
+            return;
+        }
+        AllocationPool* current = nullptr;
+        uint64_t freed[4] = {};
+        for (T* in : nodes)
+        {
+            AllocationPool* pool = poolOf(in);
+            if (pool != current)
+            {
+                releaseWords(current, freed);
+                current = pool;
+            }
+            unsigned index = indexOf(pool, in);
+            freed[index >> 6] |= (1ull << (index & 0b111111));
+        }
+        releaseWords(current, freed);
+    }
+
+    // Calls f(T*) for every allocated node. f must not allocate or dealocate through this allocator.
+    template <typename F>
+    void forEachAllocated(F&& f) const
+    {
+        for (auto* list : {availablePools_, fullyAllocatedPools_})
+        {
+            for (auto* pool = list; pool != nullptr; pool = pool->next)
+            {
+                for (unsigned wordIndex = 0; wordIndex < 4; ++wordIndex)
+                {
+                    uint64_t allocated = ~pool->allocationMask[wordIndex] & initialMask(wordIndex);
+                    while (allocated != 0x0)
+                    {
+                        unsigned char bit = bit_operations::intrincs::findFirstSet(allocated) - 1;
+                        allocated &= allocated - 1;
+                        f(nodeAt(pool, wordIndex * 64 + bit));
+                    }
+                }
+            }
+        }
+    }
+
     void clearAll()
     {
-        while (fullyAllocatedPools_ != nullptr)
+        for (auto** list : {&availablePools_, &fullyAllocatedPools_})
         {
-            moveToAvaiable(fullyAllocatedPools_);
+            while (*list != nullptr)
+            {
+                auto* pool = *list;
+                resetMasks(pool);
+                move(*list, emptyPools_, pool);
+                ++emptyPoolsCount_;
+            }
         }
-        auto* it = availablePools_;
-        while (it != nullptr)
+        liveObjects_ = 0;
+        trimIfNeeded();
+    }
+
+    // Releases completely free pools to the system until at most `keep` of them are left.
+    void releaseEmptyPools(std::size_t keep = 0)
+    {
+        while (emptyPoolsCount_ > keep)
         {
-            it->allocationMask[0] = 0xffffffffffffffffull;
-            it->allocationMask[1] = 0xffffffffffffffffull;
-            it->allocationMask[2] = 0xffffffffffffffffull;
-            it->allocationMask[3] = 0xffffffffffffffffull;
-            it = it->next;
+            auto* pool = emptyPools_;
+            unlink(emptyPools_, pool);
+            destroyPool(pool);
+            --emptyPoolsCount_;
+            --pools_;
         }
     }
 
+    void setTrimPolicy(PoolAllocatorTrimPolicy trimPolicy)
+    {
+        trimPolicy_ = trimPolicy;
+        trimIfNeeded();
+    }
+
+    PoolAllocatorStats stats() const noexcept
+    {
+        PoolAllocatorStats out;
+        out.liveObjects = liveObjects_;
+        out.pools = pools_;
+        out.bytesReserved = pools_ * PoolSize;
+        out.bytesInUse = liveObjects_ * sizeof(T);
+        out.bytesMapped = chunkSlabs_ * PoolSize;
+        return out;
+    }
+
     ~PoolAllocator()
     {
-        deleteNext(availablePools_);
-        deleteNext(fullyAllocatedPools_);
+        deleteAll(availablePools_);
+        deleteAll(emptyPools_);
+        deleteAll(fullyAllocatedPools_);
     }
 private:
+    AllocationPool* availablePool()
+    {
+        if (availablePools_ == nullptr)
+        {
+            if (emptyPools_ != nullptr)
+            {
+                --emptyPoolsCount_;
+                move(emptyPools_, availablePools_, emptyPools_);
+            }
+            else
+            {
+                ++pools_;
+                pushFront(availablePools_, createPool());
+            }
+        }
+        return availablePools_;
+    }
+
+    // Marks freed slots of pool as available again and resets freed.
+    void releaseWords(AllocationPool* pool, uint64_t (&freed)[4])
+    {
+        if (pool == nullptr)
+        {
+            return;
+        }
+        if (isFull(pool))
+        {
+            moveToAvaiable(pool);
+        }
+        std::size_t count = 0;
+        for (unsigned i = 0; i < 4; ++i)
+        {
+            if (freed[i] != 0x0)
+            {
+                pool->allocationMask[i] |= freed[i];
+                pool->summary |= (1ull << i);
+                count += std::popcount(freed[i]);
+                freed[i] = 0x0;
+            }
+        }
+        liveObjects_ -= count;
+        pool->liveNodes -= count;
+        if (pool->liveNodes == 0)
+        {
+            move(availablePools_, emptyPools_, pool);
+            ++emptyPoolsCount_;
+            trimIfNeeded();
+        }
+    }
+
+    AllocationPool* createPool()
+    {
+        SlabChunk* chunk = chunksWithRoom_ != nullptr ? chunksWithRoom_ : createChunk();
+        std::size_t index = chunk->carved;
+        if (chunk->holes > 0)
+        {
+            std::size_t word = 0;
+            while (chunk->released[word] == 0x0)
+            {
+                ++word;
+            }
+            index = word * 64 + bit_operations::intrincs::findFirstSet(chunk->released[word]) - 1;
+            chunk->released[word] &= chunk->released[word] - 1;
+            --chunk->holes;
+        }
+        else
+        {
+            ++chunk->carved;
+        }
+        ++chunk->live;
+        if (!hasRoom(chunk))
+        {
+            unlinkChunk(chunk);
+        }
+        auto* pool = std::construct_at(reinterpret_cast<AllocationPool*>(chunk->base + index * PoolSize));
+        pool->chunk = chunk;
+        resetMasks(pool);
+        return pool;
+    }
+
+    void destroyPool(AllocationPool* in)
+    {
+        SlabChunk* chunk = in->chunk;
+        const std::size_t index = (reinterpret_cast<unsigned char*>(in) - chunk->base) / PoolSize;
+        std::destroy_at(in);
+        if (--chunk->live == 0)
+        {
+            if (hasRoom(chunk))
+            {
+                unlinkChunk(chunk);
+            }
+            chunkSlabs_ -= chunk->slabs;
+            non_std::internal::freePages(chunk->base, chunk->slabs * PoolSize, pages_, PoolSize);
+            delete chunk;
+            return;
+        }
+        if (!hasRoom(chunk))
+        {
+            pushChunk(chunk);
+        }
+        chunk->released[index / 64] |= (1ull << (index % 64));
+        ++chunk->holes;
+
+        // Hand back the pages no live slab shares.
+        if constexpr (SlabsPerPage == 1)
+        {
+            non_std::internal::discardPages(in, PoolSize, pages_);
+        }
+        else
+        {
+            const std::size_t first = index / SlabsPerPage * SlabsPerPage;
+            const uint64_t page = (SlabsPerPage == 64 ? ~0ull : (1ull << SlabsPerPage) - 1) << (first % 64);
+            if ((chunk->released[first / 64] & page) == page)
+            {
+                non_std::internal::discardPages(chunk->base + first * PoolSize, non_std::internal::PageSize, pages_);
+            }
+        }
+    }
+
+    // As large as all chunks held so far, so the memory held doubles, within [MinChunkSize, MaxChunkSize].
+    SlabChunk* createChunk()
+    {
+        const std::size_t bytes = pages_.hugePages
+            ? MaxChunkSize
+            : std::clamp(std::bit_ceil(chunkSlabs_ * PoolSize), MinChunkSize, MaxChunkSize);
+        auto chunk = std::make_unique<SlabChunk>();
+        chunk->slabs = bytes / PoolSize;
+        chunk->released = std::make_unique<uint64_t[]>((chunk->slabs + 63) / 64);
+        chunk->base = static_cast<unsigned char*>(non_std::internal::allocatePages(bytes, pages_, PoolSize, false));
+        chunkSlabs_ += chunk->slabs;
+        pushChunk(chunk.get());
+        return chunk.release();
+    }
+
+    static bool hasRoom(const SlabChunk* in)
+    {
+        return in->holes > 0 || in->carved < in->slabs;
+    }
+
+    void pushChunk(SlabChunk* in)
+    {
+        in->prev = nullptr;
+        in->next = chunksWithRoom_;
+        if (chunksWithRoom_ != nullptr)
+        {
+            chunksWithRoom_->prev = in;
+        }
+        chunksWithRoom_ = in;
+    }
+
+    void unlinkChunk(SlabChunk* in)
+    {
+        if (in->prev != nullptr)
+        {
+            in->prev->next = in->next;
+        }
+        else
+        {
+            chunksWithRoom_ = in->next;
+        }
+        if (in->next != nullptr)
+        {
+            in->next->prev = in->prev;
+        }
+        in->prev = nullptr;
+        in->next = nullptr;
+    }
+
+    static void resetMasks(AllocationPool* in)
+    {
+        for (unsigned i = 0; i < 4; ++i)
+        {
+            in->allocationMask[i] = initialMask(i);
+        }
+        in->summary = initialSummary;
+        in->liveNodes = 0;
+    }
+
+    static T* nodeAt(AllocationPool* pool, unsigned index)
+    {
+        return reinterpret_cast<T*>(reinterpret_cast<unsigned char*>(pool) + NodesOffset + index * sizeof(T));
+    }
+
+    static AllocationPool* poolOf(T* in)
+    {
+        return reinterpret_cast<AllocationPool*>(reinterpret_cast<uintptr_t>(in) & ~uintptr_t(PoolSize - 1));
+    }
+
+    static unsigned indexOf(AllocationPool* pool, T* in)
+    {
+        return (reinterpret_cast<unsigned char*>(in) - reinterpret_cast<unsigned char*>(pool) - NodesOffset) / sizeof(T);
+    }
+
+    void trimIfNeeded()
+    {
+        if (emptyPoolsCount_ > trimPolicy_.highWaterMark)
+        {
+            releaseEmptyPools(trimPolicy_.lowWaterMark);
+        }
+    }
+
     bool isFull(AllocationPool* in)
     {
-        return (in->allocationMask[0] == 0x0) & (in->allocationMask[1] == 0x0)
-               & (in->allocationMask[2] == 0x0) & (in->allocationMask[3] == 0x0);
+        return in->summary == 0x0;
     }
 
     void moveTofullyAllocated(AllocationPool* in)
     {
-        availablePools_ = in->next;
-        if (fullyAllocatedPools_ != nullptr)
+        move(availablePools_, fullyAllocatedPools_, in);
+    }
+
+    void moveToAvaiable(AllocationPool* in)
+    {
+        move(fullyAllocatedPools_, availablePools_, in);
+    }
+
+    static void move(AllocationPool*& from, AllocationPool*& to, AllocationPool* in)
+    {
+        unlink(from, in);
+        pushFront(to, in);
+    }
+
+    static void unlink(AllocationPool*& head, AllocationPool* in)
+    {
+        if (in->prev != nullptr)
+        {
+            in->prev->next = in->next;
+        }
+        else
         {
-            fullyAllocatedPools_->prev = in;
+            head = in->next;
         }
-        in->next = fullyAllocatedPools_;
-        fullyAllocatedPools_ = in;
+        if (in->next != nullptr)
+        {
+            in->next->prev = in->prev;
+        }
+        in->prev = nullptr;
+        in->next = nullptr;
     }
 
-    void moveToAvaiable(AllocationPool* in)
+    static void pushFront(AllocationPool*& head, AllocationPool* in)
     {
-        fullyAllocatedPools_ = in->next;
-        if (availablePools_ != nullptr)
+        in->prev = nullptr;
+        in->next = head;
+        if (head != nullptr)
         {
-            availablePools_->prev = in;
+            head->prev = in;
         }
-        in->next = availablePools_;
-        availablePools_ = in;
+        head = in;
     }
 
-    void deleteNext(AllocationPool* in)
+    // Iterative on purpose: a recursive walk overflows the stack with ~100k pools.
+    void deleteAll(AllocationPool* in)
     {
-        if (in != nullptr)
+        while (in != nullptr)
         {
-            deleteNext(in->next);
-            delete in;
+            auto* next = in->next;
+            destroyPool(in);
+            in = next;
         }
     }
 
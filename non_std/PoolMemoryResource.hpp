@@ -0,0 +1,193 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory_resource>
+#include <new>
+#include <tuple>
+#include <utility>
+
+#include <non_std/PoolAlocator.hpp>
+
+/*
+std::pmr::memory_resource on top of PoolAllocator.
+1. Not thread safe, same as PoolAllocator.
+2. Requests up to MaxPooledSize bytes (alignment up to MaxPooledAlignment) are served from one
+   PoolAllocator per SizeClassStep-byte size class. Anything else goes to the upstream resource.
+3. Pooled memory is returned to the system when the resource is destroyed or trimmed.
+*/
+class PoolMemoryResource : public std::pmr::memory_resource
+{
+public:
+    static constexpr std::size_t SizeClassStep = 8;
+    static constexpr std::size_t MaxPooledSize = 256;
+    static constexpr std::size_t MaxPooledAlignment = 16;
+
+    explicit PoolMemoryResource(std::pmr::memory_resource* upstream = std::pmr::new_delete_resource()) noexcept
+        : upstream_(upstream)
+    {
+    }
+
+    PoolMemoryResource(const PoolMemoryResource&) = delete;
+    PoolMemoryResource& operator=(const PoolMemoryResource&) = delete;
+
+    std::pmr::memory_resource* upstream() const noexcept
+    {
+        return upstream_;
+    }
+
+    PoolAllocatorStats stats() const noexcept
+    {
+        PoolAllocatorStats out;
+        std::apply([&out](const auto&... pools) { (accumulate(out, pools.stats()), ...); }, pools_);
+        return out;
+    }
+
+    void setTrimPolicy(PoolAllocatorTrimPolicy policy)
+    {
+        std::apply([policy](auto&... pools) { (pools.setTrimPolicy(policy), ...); }, pools_);
+    }
+
+    void releaseEmptyPools(std::size_t keep = 0)
+    {
+        std::apply([keep](auto&... pools) { (pools.releaseEmptyPools(keep), ...); }, pools_);
+    }
+
+private:
+    // Block alignment is the largest power of two dividing Size, capped at MaxPooledAlignment.
+    template <std::size_t Size>
+    struct alignas(std::min(Size & (~Size + 1), MaxPooledAlignment)) Block
+    {
+        unsigned char bytes[Size];
+    };
+
+    static constexpr std::size_t SizeClasses = MaxPooledSize / SizeClassStep;
+
+    template <std::size_t... Class>
+    static auto makePools(std::index_sequence<Class...>)
+        -> std::tuple<PoolAllocator<Block<(Class + 1) * SizeClassStep>>...>;
+
+    using Pools = decltype(makePools(std::make_index_sequence<SizeClasses>{}));
+
+    // Size class index for a request, or SizeClasses when it must go upstream.
+    static std::size_t sizeClass(std::size_t bytes, std::size_t alignment) noexcept
+    {
+        if (alignment > MaxPooledAlignment)
+        {
+            return SizeClasses;
+        }
+        // Rounding the size up to a multiple of the alignment gives a class aligned at least that much.
+        auto granularity = std::max(alignment, SizeClassStep);
+        auto size = std::max<std::size_t>((bytes + granularity - 1) / granularity * granularity, SizeClassStep);
+        return size <= MaxPooledSize ? size / SizeClassStep - 1 : SizeClasses;
+    }
+
+    template <std::size_t... Class>
+    void* allocateFrom(std::size_t sizeClass, std::index_sequence<Class...>)
+    {
+        void* out = nullptr;
+        ((sizeClass == Class ? (out = std::get<Class>(pools_).allocate(), true) : false) || ...);
+        return out;
+    }
+
+    template <std::size_t... Class>
+    void dealocateTo(std::size_t sizeClass, void* in, std::index_sequence<Class...>)
+    {
+        ((sizeClass == Class
+          ? (std::get<Class>(pools_).dealocate(static_cast<Block<(Class + 1) * SizeClassStep>*>(in)), true)
+          : false) || ...);
+    }
+
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override
+    {
+        auto sizeClassIndex = sizeClass(bytes, alignment);
+        if (sizeClassIndex == SizeClasses)
+        {
+            return upstream_->allocate(bytes, alignment);
+        }
+        return allocateFrom(sizeClassIndex, std::make_index_sequence<SizeClasses>{});
+    }
+
+    void do_deallocate(void* in, std::size_t bytes, std::size_t alignment) override
+    {
+        auto sizeClassIndex = sizeClass(bytes, alignment);
+        if (sizeClassIndex == SizeClasses)
+        {
+            upstream_->deallocate(in, bytes, alignment);
+            return;
+        }
+        dealocateTo(sizeClassIndex, in, std::make_index_sequence<SizeClasses>{});
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+    {
+        return this == &other;
+    }
+
+    static void accumulate(PoolAllocatorStats& out, const PoolAllocatorStats& in)
+    {
+        out.liveObjects += in.liveObjects;
+        out.pools += in.pools;
+        out.bytesReserved += in.bytesReserved;
+        out.bytesInUse += in.bytesInUse;
+    }
+
+    std::pmr::memory_resource* upstream_;
+    Pools pools_;
+};
+
+/*
+Standard allocator for node based containers (std::list, std::map, std::unordered_map, ...).
+Single objects come from the PoolMemoryResource size classes; arrays (e.g. unordered_map buckets)
+go straight to its upstream resource.
+*/
+template <typename T>
+class PoolStdAllocator
+{
+public:
+    using value_type = T;
+
+    explicit PoolStdAllocator(PoolMemoryResource* resource) noexcept
+        : resource_(resource)
+    {
+    }
+
+    template <typename U>
+    PoolStdAllocator(const PoolStdAllocator<U>& other) noexcept
+        : resource_(other.resource())
+    {
+    }
+
+    T* allocate(std::size_t n)
+    {
+        if (n == 1)
+        {
+            return static_cast<T*>(resource_->allocate(sizeof(T), alignof(T)));
+        }
+        return static_cast<T*>(resource_->upstream()->allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T* in, std::size_t n)
+    {
+        if (n == 1)
+        {
+            resource_->deallocate(in, sizeof(T), alignof(T));
+            return;
+        }
+        resource_->upstream()->deallocate(in, n * sizeof(T), alignof(T));
+    }
+
+    PoolMemoryResource* resource() const noexcept
+    {
+        return resource_;
+    }
+
+    template <typename U>
+    bool operator==(const PoolStdAllocator<U>& other) const noexcept
+    {
+        return resource_ == other.resource();
+    }
+
+private:
+    PoolMemoryResource* resource_;
+};
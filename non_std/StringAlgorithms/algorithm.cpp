@@ -1,5 +1,7 @@
 #include "algorithm.hpp"
 
+#include <algorithm>
+
 std::string ltrim(const std::string& in)
 {
     auto pos = in.find_first_not_of(' ');
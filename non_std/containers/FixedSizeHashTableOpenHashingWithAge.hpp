@@ -1,26 +1,204 @@
 #pragma once
 
+#include <algorithm>
 #include <array>
+#include <bit>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
 #include <vector>
 #include <utility>
 #include <optional>
+#include <span>
 #include <stdint.h>
 
+#include "Hash.hpp"
 #include "Traits.hpp"
 
 #include <non_std/internal/Logger.hpp>
+#include <non_std/internal/MappedFile.hpp>
+#include <non_std/internal/PageAllocation.hpp>
+#include <non_std/internal/Prefetch.hpp>
 #include <unordered_map>
 
 namespace non_std::containers
 {
 
+/* Age of an entry is its recency rank in the bucket; every hit updates it. */
+struct AgeByRecency {};
+/* Age of an entry is the generation (advanced by the caller) in which it was last stored or hit. */
+struct AgeByGeneration {};
+
+/* Buckets hold whole keys. */
+struct FullKeys
+{
+    template <typename TKey>
+    using Stored = TKey;
+
+    template <typename TKey>
+    static const TKey& stored(const TKey& key, uint64_t) noexcept
+    {
+        return key;
+    }
+};
+
+/*
+Buckets hold only the top bits of the remixed key hash (TSignature is uint16_t or uint32_t): the raw
+hash may be the identity (std::hash of an integer), whose top bits are 0 for small keys, while bucket
+index uses its low bits. Two keys with the same bucket and signature are the same entry: a lookup of a
+missing key in a full bucket finds a wrong entry with probability about HashTries / 2^bits
+(8 / 2^16 = 1.2e-4 for 16 bits, 8 / 2^32 = 1.9e-9 for 32 bits), and a store may overwrite it.
+*/
+template <typename TSignature>
+struct KeySignatures
+{
+    static_assert(std::is_unsigned_v<TSignature> && sizeof(TSignature) < sizeof(uint64_t));
+
+    template <typename TKey>
+    using Stored = TSignature;
+
+    template <typename TKey>
+    static TSignature stored(const TKey&, uint64_t hash) noexcept
+    {
+        return static_cast<TSignature>(mix64(hash) >> (64 - 8 * sizeof(TSignature)));
+    }
+};
+
+/* Occupied, unlocked slot a replacement policy may pick. Larger staleness is older. */
+template <typename TValue>
+struct ReplacementCandidate
+{
+    unsigned int slot;
+    uint16_t staleness;
+    const TValue* value;
+};
+
+/*
+Replacement policies: victim() picks the index (into candidates) of the entry a new key replaces when
+its bucket has no free slot. hash is the raw Hash output, which may be the identity (std::hash of an
+integer), so policies picking by hash remix it first. incoming is the value being stored, nullptr
+when it is constructed in place (operator[], tryEmplace()). TPriority is a functor:
+int priority(const TValue&), e.g. search depth.
+*/
+/* The oldest entry. */
+struct ReplaceOldest
+{
+    template <typename TValue>
+    static std::size_t victim(std::span<const ReplacementCandidate<TValue>> candidates, const TValue*, uint64_t) noexcept
+    {
+        std::size_t out = 0;
+        for (std::size_t i = 1; i < candidates.size(); ++i)
+        {
+            if (candidates[i].staleness > candidates[out].staleness)
+            {
+                out = i;
+            }
+        }
+        return out;
+    }
+};
+
+/* Direct mapped: the entry in the slot picked by the hash of the new key, whatever its age. */
+struct ReplaceAlways
+{
+    template <typename TValue>
+    static std::size_t victim(std::span<const ReplacementCandidate<TValue>> candidates, const TValue*, uint64_t hash) noexcept
+    {
+        return mix64(hash) % candidates.size();
+    }
+};
+
+/* The entry with the lowest priority - TAgeWeight * staleness, so old deep entries eventually go too. */
+template <typename TPriority, int TAgeWeight = 8>
+struct ReplaceLowestPriority
+{
+    template <typename TValue>
+    static std::size_t victim(std::span<const ReplacementCandidate<TValue>> candidates, const TValue*, uint64_t) noexcept
+    {
+        auto keep = [](const ReplacementCandidate<TValue>& candidate) {
+            return int64_t(TPriority{}(*candidate.value)) - int64_t(TAgeWeight) * candidate.staleness;
+        };
+        std::size_t out = 0;
+        for (std::size_t i = 1; i < candidates.size(); ++i)
+        {
+            if (keep(candidates[i]) < keep(candidates[out]))
+            {
+                out = i;
+            }
+        }
+        return out;
+    }
+};
+
+/* Slot 0 of a bucket is protected: replaced only by a value of at least its priority. Other */
+/* entries are replaced always, in the slot picked by the hash of the new key. */
+template <typename TPriority>
+struct ReplaceTwoTier
+{
+    template <typename TValue>
+    static std::size_t victim(std::span<const ReplacementCandidate<TValue>> candidates, const TValue* incoming, uint64_t hash) noexcept
+    {
+        const bool hasProtected = candidates.front().slot == 0;
+        if (hasProtected && (candidates.size() == 1
+                             || (incoming != nullptr && TPriority{}(*incoming) >= TPriority{}(*candidates.front().value))))
+        {
+            return 0;
+        }
+        const std::size_t first = hasProtected ? 1 : 0;
+        return first + mix64(hash) % (candidates.size() - first);
+    }
+};
+
+/*
+Hash table which never grows: a key can only be in the HashTries slots of its bucket, and a new one
+overwrites the least recently used of them when none is free.
+1. A bucket is 64-byte aligned: bucket epoch, one 16-bit meta word per slot (2-bit occupancy,
+   14-bit age) and the keys. HashTries is the largest power of two (at least 4) whose metas and
+   keys fit in one line, e.g. 4 for 8-byte keys. With keys of up to 8 bytes (or signatures) the
+   bucket is that one line and probing a key costs one cache miss; larger keys make it span
+   sizeof(Bucket) / 64 lines. Values live in a separate array and are touched only on a hit, so a
+   hit costs one more miss for its value, whatever the key size.
+2. Age is the recency rank within the bucket (0 = most recently used), so it never wraps.
+3. Size is given at construction in entries (rounded up to a power of two) or in bytes
+   (withMemoryBudget, rounded down). resize() rehashes live entries, least recent first, into a new
+   table.
+4. clear() is O(1) and keeps the allocation: it bumps the table epoch, and a bucket of an older epoch
+   is empty, except for entries locked by a live PersistPointer, which survive, also once unlocked
+   before anything else touched their bucket. Values are destroyed
+   when their slot is reused, or with the table.
+5. Pointers (PersistPointer) are invalidated by resize() and by assignment.
+6. Which entry a new key replaces, when its bucket has no free slot, is up to TReplacement.
+7. TKeys = KeySignatures<uint16_t or uint32_t> stores key signatures instead of keys (see KeySignatures
+   for the false positive rate), so more slots share a line. resize() then is not available.
+8. probe() is the read only lookup: it copies the value out and leaves locks and ages alone.
+   prefetch() starts loading the bucket lines and value slots of a key, so a lookup issued later
+   and the read of its value find them in cache.
+9. With AgeByGeneration the 14 age bits hold a generation tag instead and the caller calls
+   newGeneration() per search or epoch. Replacement takes the entry of the oldest generation, a hit
+   writes the tag only when the entry is from an earlier generation. Only probe() leaves the line
+   clean: get() still locks the entry for the life of its PersistPointer, which writes the meta
+   word twice. Tags wrap silently after 16384 generations: staleness is counted modulo 2^14, so an
+   entry untouched for 16384 generations looks as fresh as a new one and is not picked as victim.
+10. Buckets and values are one block of pages, placed as the PagePolicy given at construction asks
+    (huge pages, NUMA interleaving, initialization by several threads); resize() keeps the policy.
+    save() writes the block behind a header, and openMapped() maps such a file back copy on write,
+    so a restarted process starts with the saved entries without reading or parsing the file up
+    front. TKey, TValue must be trivially copyable, and Hash must give the same results in the
+    process which opens the file.
+*/
 template<typename TKey,
         typename TValue,
-        typename Hash = std::hash<TKey>>
+        typename Hash = std::hash<TKey>,
+        typename TAging = AgeByRecency,
+        typename TReplacement = ReplaceOldest,
+        typename TKeys = FullKeys>
 class FixedSizeHashTableOpenHashingWithAge
 {
-struct Node;
-    enum class Occupancy
+    enum class Occupancy : uint16_t
     {
         free = 0,
         deleted,
@@ -28,204 +206,676 @@ struct Node;
         locked,
     };
 
+    static constexpr std::size_t CacheLine = 64;
+    static constexpr unsigned int AgeBits = 14;
+    static constexpr uint16_t AgeMask = (1u << AgeBits) - 1;
+
+    using StoredKey = typename TKeys::template Stored<TKey>;
+
+    static constexpr std::size_t keysEnd(std::size_t slots)
+    {
+        auto keys = (sizeof(uint16_t) * (1 + slots) + alignof(StoredKey) - 1) / alignof(StoredKey) * alignof(StoredKey);
+        return keys + slots * sizeof(StoredKey);
+    }
+
+    static constexpr unsigned int slotsPerBucket()
+    {
+        unsigned int slots = 4;
+        while (keysEnd(slots * 2) <= CacheLine)
+        {
+            slots *= 2;
+        }
+        return slots;
+    }
+
+    struct Bucket;
+
 public:
     /* This is problematic */
-    /* It may crash operator[] in case all slots visited there are locked */
+    /* operator[] returns nullptr in case all slots visited there are locked */
     /* Possibly detached node is better idea. In such scenario, pointer maybe out of collection. */
     struct PersistPointer
     {
-        explicit PersistPointer(Node* in)
+        PersistPointer(uint16_t* meta, TValue* value, Bucket* bucket = nullptr, const uint16_t* tableEpoch = nullptr)
+            : meta_(meta)
+            , value_(value)
+            , bucket_(bucket)
+            , tableEpoch_(tableEpoch)
         {
-            node_ = in;
-            if (node_ != nullptr)
-                in->occupancy_ = Occupancy::locked;
+            if (meta_ != nullptr)
+                *meta_ = withOccupancy(*meta_, Occupancy::locked);
         }
+        PersistPointer(PersistPointer&& other) noexcept
+            : meta_(std::exchange(other.meta_, nullptr))
+            , value_(std::exchange(other.value_, nullptr))
+            , bucket_(std::exchange(other.bucket_, nullptr))
+            , tableEpoch_(std::exchange(other.tableEpoch_, nullptr))
+        {
+        }
+        PersistPointer(const PersistPointer&) = delete;
+        PersistPointer& operator=(const PersistPointer&) = delete;
         ~PersistPointer ()
         {
-            if (node_ != nullptr) node_->occupancy_ = Occupancy::occupied;
+            if (meta_ == nullptr)
+            {
+                return;
+            }
+            // A clear() since locking left the bucket in an older epoch: move it to the current one
+            // while the entry is still locked, so the entry survives unlocking.
+            if (bucket_ != nullptr && bucket_->epoch != *tableEpoch_)
+            {
+                refresh(*bucket_, *tableEpoch_);
+            }
+            *meta_ = withOccupancy(*meta_, Occupancy::occupied);
         }
         TValue* operator->()
         {
-            return &node_->value_;
+            return value_;
         }
         operator TValue*()
         {
-            if (node_ != nullptr)
-                return &node_->value_;
-            return nullptr;
+            return value_;
         }
 
-        Node* node_;
+        uint16_t* meta_;
+        TValue* value_;
+        Bucket* bucket_;
+        const uint16_t* tableEpoch_;
     };
 
 /* Traits section */
 public:
     constexpr static OverwriteOlderElements_Taq OverwriteCategory {};
-    constexpr static unsigned int HashTries = 5;
+    constexpr static unsigned int HashTries = slotsPerBucket();
+    constexpr static std::size_t DefaultEntries = std::size_t(1) << 21;
     using pointer = PersistPointer;
 /* Internal types section */
 private:
-    struct Node
+    struct alignas(CacheLine) Bucket
+    {
+        uint16_t epoch = 0;
+        uint16_t meta[HashTries] = {};
+        StoredKey keys[HashTries] = {};
+    };
+
+    /* Buckets followed by values: pages of its own, or a copy on write mapping of a snapshot. */
+    class Storage
+    {
+        static_assert(alignof(TValue) <= CacheLine);
+    public:
+        static std::size_t bytesFor(std::size_t buckets) noexcept
+        {
+            return buckets * (sizeof(Bucket) + HashTries * sizeof(TValue));
+        }
+
+        Storage() noexcept = default;
+
+        Storage(std::size_t buckets, const non_std::internal::PagePolicy& pages)
+            : pages_(pages)
+        {
+            if (buckets == 0)
+            {
+                return;
+            }
+            auto* data = static_cast<unsigned char*>(non_std::internal::allocatePages(bytesFor(buckets), pages_, CacheLine));
+            auto* values = reinterpret_cast<TValue*>(data + buckets * sizeof(Bucket));
+            if constexpr (std::is_nothrow_default_constructible_v<TValue>)
+            {
+                // The thread which initializes a part of the buckets also initializes their values.
+                non_std::internal::firstTouch(buckets, pages_.touchThreads, [data, values](std::size_t begin, std::size_t end) {
+                    std::uninitialized_value_construct(reinterpret_cast<Bucket*>(data) + begin, reinterpret_cast<Bucket*>(data) + end);
+                    std::uninitialized_value_construct(values + begin * HashTries, values + end * HashTries);
+                });
+            }
+            else
+            {
+                std::uninitialized_value_construct_n(reinterpret_cast<Bucket*>(data), buckets);
+                try
+                {
+                    std::uninitialized_value_construct_n(values, buckets * HashTries);
+                }
+                catch (...)
+                {
+                    non_std::internal::freePages(data, bytesFor(buckets), pages_, CacheLine);
+                    throw;
+                }
+            }
+            data_ = data;
+            buckets_ = buckets;
+        }
+
+        Storage(non_std::internal::MappedFile file, std::size_t offset, std::size_t buckets) noexcept
+            : file_(std::move(file))
+            , data_(file_.mutableData() + offset)
+            , buckets_(buckets)
+        {
+        }
+
+        Storage(const Storage& other)
+            : Storage(other.buckets_, other.pages_)
+        {
+            std::copy(other.buckets().begin(), other.buckets().end(), buckets().begin());
+            std::copy(other.values().begin(), other.values().end(), values().begin());
+        }
+
+        Storage(Storage&& other) noexcept
+        {
+            swap(other);
+        }
+
+        Storage& operator=(Storage other) noexcept
+        {
+            swap(other);
+            return *this;
+        }
+
+        ~Storage()
+        {
+            if (data_ == nullptr || file_.data() != nullptr)
+            {
+                return;
+            }
+            std::destroy(values().begin(), values().end());
+            non_std::internal::freePages(data_, bytesFor(buckets_), pages_, CacheLine);
+        }
+
+        void swap(Storage& other) noexcept
+        {
+            file_.swap(other.file_);
+            std::swap(data_, other.data_);
+            std::swap(buckets_, other.buckets_);
+            std::swap(pages_, other.pages_);
+        }
+
+        const non_std::internal::PagePolicy& pages() const noexcept
+        {
+            return pages_;
+        }
+
+        std::span<Bucket> buckets() noexcept
+        {
+            return {reinterpret_cast<Bucket*>(data_), buckets_};
+        }
+
+        std::span<const Bucket> buckets() const noexcept
+        {
+            return {reinterpret_cast<const Bucket*>(data_), buckets_};
+        }
+
+        std::span<TValue> values() noexcept
+        {
+            return {reinterpret_cast<TValue*>(data_ + buckets_ * sizeof(Bucket)), buckets_ * HashTries};
+        }
+
+        std::span<const TValue> values() const noexcept
+        {
+            return {reinterpret_cast<const TValue*>(data_ + buckets_ * sizeof(Bucket)), buckets_ * HashTries};
+        }
+
+    private:
+        non_std::internal::MappedFile file_;
+        unsigned char* data_ = nullptr;
+        std::size_t buckets_ = 0;
+        non_std::internal::PagePolicy pages_;
+    };
+
+    struct SnapshotHeader
     {
-        Occupancy occupancy_ = Occupancy::free;
-        uint64_t age_ = 0u;
-        TKey key_ = {};
-        TValue value_ = {};
+        uint64_t magic;
+        uint64_t keySize;
+        uint64_t storedKeySize;
+        uint64_t valueSize;
+        uint64_t hashTries;
+        uint64_t byGeneration;
+        uint64_t buckets;
+        uint16_t epoch;
+        uint16_t generation;
     };
+    static_assert(sizeof(SnapshotHeader) <= CacheLine);
+
+    static constexpr uint64_t SnapshotMagic = 0x314254454741534eull; // "NSAGETB1"
 
 public:
-    FixedSizeHashTableOpenHashingWithAge()
-        : nodes_(std::vector<Node>((1u  << 21u), Node{}))
+    explicit FixedSizeHashTableOpenHashingWithAge(std::size_t entries = DefaultEntries,
+                                                  const non_std::internal::PagePolicy& pages = {})
+        : storage_(roundEntries(entries) / HashTries, pages)
+        , bucketMask_(storage_.buckets().size() - 1)
     {
     }
 
-    FixedSizeHashTableOpenHashingWithAge(const FixedSizeHashTableOpenHashingWithAge & other)
+    /* Largest table whose buckets and values fit in bytes. */
+    static FixedSizeHashTableOpenHashingWithAge withMemoryBudget(std::size_t bytes, const non_std::internal::PagePolicy& pages = {})
     {
-        nodes_ = other.nodes_;
-        age_ = other.age_;
+        constexpr std::size_t entryBytes = sizeof(Bucket) / HashTries + sizeof(TValue);
+        return FixedSizeHashTableOpenHashingWithAge(std::bit_floor(std::max<std::size_t>(bytes / entryBytes, 1)), pages);
     }
 
-    FixedSizeHashTableOpenHashingWithAge& operator=(const FixedSizeHashTableOpenHashingWithAge& other)
+    FixedSizeHashTableOpenHashingWithAge(const FixedSizeHashTableOpenHashingWithAge&) = default;
+    FixedSizeHashTableOpenHashingWithAge& operator=(const FixedSizeHashTableOpenHashingWithAge&) = default;
+
+    /* Maps a file written by save(). Pages are read in as buckets are touched, or all at once with */
+    /* populate. Throws std::runtime_error when the file holds a table of other types. */
+    static FixedSizeHashTableOpenHashingWithAge openMapped(const std::string& path, bool populate = false)
+        requires std::is_trivially_copyable_v<TKey> && std::is_trivially_copyable_v<TValue>
     {
-        if (this == &other)
+        non_std::internal::MappedFile file(path, true, populate);
+        SnapshotHeader header {};
+        if (file.size() >= CacheLine)
         {
-            return *this;
+            std::memcpy(&header, file.data(), sizeof(header));
+        }
+        if (header.magic != SnapshotMagic || header.keySize != sizeof(TKey) || header.storedKeySize != sizeof(StoredKey)
+            || header.valueSize != sizeof(TValue) || header.hashTries != HashTries
+            || header.byGeneration != std::is_same_v<TAging, AgeByGeneration>
+            || !std::has_single_bit(header.buckets) || file.size() != CacheLine + Storage::bytesFor(header.buckets)
+            || reinterpret_cast<uintptr_t>(file.data()) % CacheLine != 0)
+        {
+            throw std::runtime_error("FixedSizeHashTableOpenHashingWithAge: " + path + " does not hold a table of these types");
         }
-        nodes_ = other.nodes_;
-        age_ = other.age_;
-        return *this;
+        return FixedSizeHashTableOpenHashingWithAge(Storage(std::move(file), CacheLine, header.buckets), header.epoch, header.generation);
     }
 
-    pointer get(const TKey& key) noexcept
+    /* Locked entries are saved as occupied. */
+    void save(const std::string& path) const
+        requires std::is_trivially_copyable_v<TKey> && std::is_trivially_copyable_v<TValue>
     {
-        LOG ("get: " << key << std::endl);
-        auto hash = hashFunction_(key);
-        auto bucket = hash & hashMask;
-
-        for (std::decay<decltype(HashTries)>::type i = 0; i < HashTries; ++i)
+        const auto buckets = storage_.buckets();
+        const auto values = storage_.values();
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        char head[CacheLine] = {};
+        const SnapshotHeader header {SnapshotMagic, sizeof(TKey), sizeof(StoredKey), sizeof(TValue), HashTries,
+            std::is_same_v<TAging, AgeByGeneration>, buckets.size(), epoch_, generation_};
+        std::memcpy(head, &header, sizeof(header));
+        out.write(head, sizeof(head));
+        std::array<Bucket, 256> chunk;
+        for (std::size_t begin = 0; begin < buckets.size(); begin += chunk.size())
         {
-            if ((nodes_[bucket].occupancy_ == Occupancy::occupied
-                    || nodes_[bucket].occupancy_ == Occupancy::locked)
-                && nodes_[bucket].key_ == key)
-            {
-                nodes_[bucket].age_ = ++age_;
-                LOG ("get: key: " << key << " exist in exist in bucket: " << bucket << std::endl);
-                return PersistPointer(&nodes_[bucket]);
-            }
-            if (nodes_[bucket].occupancy_ == Occupancy::free)
+            const auto count = std::min(chunk.size(), buckets.size() - begin);
+            std::copy_n(buckets.begin() + begin, count, chunk.begin());
+            for (std::size_t b = 0; b < count; ++b)
             {
-                LOG("get: key: " << key << " not exist because bucket: " << bucket << " is empty" << std::endl);
-                return PersistPointer(nullptr);
+                for (auto& meta : chunk[b].meta)
+                {
+                    if (occupancyOf(meta) == Occupancy::locked)
+                    {
+                        meta = withOccupancy(meta, Occupancy::occupied);
+                    }
+                }
             }
-            bucket = getBucket(bucket);
+            out.write(reinterpret_cast<const char*>(chunk.data()), static_cast<std::streamsize>(count * sizeof(Bucket)));
+        }
+        out.write(reinterpret_cast<const char*>(values.data()), static_cast<std::streamsize>(values.size_bytes()));
+        if (!out)
+        {
+            throw std::runtime_error("FixedSizeHashTableOpenHashingWithAge: cannot write " + path);
         }
-        LOG("get: key: " << key << "Not exist - to many hash retries" << std::endl);
-        return PersistPointer(nullptr);;
     }
 
-    auto getBucket(uint64_t in)
+    std::size_t capacity() const noexcept
     {
-        return (1 + in) & hashMask;
+        return storage_.values().size();
     }
 
-    void store(const TKey& key, const TValue& value)
+    std::size_t memoryUsage() const noexcept
     {
-        auto hash = hashFunction_(key);
-        auto bucket = hash & hashMask;
+        return Storage::bytesFor(storage_.buckets().size());
+    }
 
-        Node* oldestElem = nullptr;
-        uint64_t oldestAge = 0u;
+    /* Entries stored from now on are younger than all earlier ones. */
+    void newGeneration() noexcept requires std::is_same_v<TAging, AgeByGeneration>
+    {
+        generation_ = (generation_ + 1) & AgeMask;
+    }
 
-        for (std::decay<decltype(HashTries)>::type  i = 0; i < HashTries; ++i)
+    void clear() noexcept
+    {
+        if (++epoch_ == 0)
         {
-            if (nodes_[bucket].occupancy_ == Occupancy::occupied && nodes_[bucket].key_ == key)
+            // Every 65536 clears the epoch wraps: empty the buckets for real so no old epoch comes back.
+            for (auto& bucket : storage_.buckets())
             {
-                nodes_[bucket].value = value;
-                nodes_[bucket].age_ = ++age_;
-                return;
+                refresh(bucket, epoch_);
+                bucket.epoch = 0;
             }
-            if (nodes_[bucket].occupancy_ == Occupancy::free)
+            epoch_ = 1;
+        }
+    }
+
+    /* Moves live entries to a table of entries slots (rounded up to a power of two). When it is */
+    /* smaller, entries are inserted least recent first, so the most recent win the slots. */
+    void resize(std::size_t entries) requires std::is_same_v<TKeys, FullKeys>
+    {
+        auto old = std::exchange(storage_, Storage(roundEntries(entries) / HashTries, storage_.pages()));
+        const auto oldBuckets = old.buckets();
+        const auto oldValues = old.values();
+        bucketMask_ = storage_.buckets().size() - 1;
+        std::vector<std::pair<uint16_t, std::size_t>> live;
+        for (std::size_t b = 0; b < oldBuckets.size(); ++b)
+        {
+            for (unsigned int s = 0; s < HashTries; ++s)
             {
-                create(nodes_[bucket], key, value);
-                return;
+                if (isLive(oldBuckets[b], s))
+                {
+                    live.emplace_back(staleness(oldBuckets[b].meta[s]), b * HashTries + s);
+                }
             }
-            if (nodes_[bucket].occupancy_ == Occupancy::deleted)
+        }
+        std::stable_sort(live.begin(), live.end(), [](const auto& lhs, const auto& rhs) { return lhs.first > rhs.first; });
+        for (const auto& [age, index] : live)
+        {
+            // No slot of the new table is locked, so a slot is always found.
+            const TKey& key = oldBuckets[index / HashTries].keys[index % HashTries];
+            auto [bucket, slot, found, stored] = findSlot(key);
+            create(*bucket, slot, stored, std::move(oldValues[index]));
+            if constexpr (std::is_same_v<TAging, AgeByGeneration>)
             {
-                oldestElem = &nodes_[bucket];
-                oldestAge = age_;
-                bucket = getBucket(bucket);
-                continue;
+                bucket->meta[slot] = withAge(bucket->meta[slot], ageOf(oldBuckets[index / HashTries].meta[index % HashTries]));
             }
-            if (nodes_[bucket].age_ > oldestAge)
+        }
+    }
+
+    pointer get(const TKey& key) noexcept
+    {
+        LOG ("get: " << key << std::endl);
+        const uint64_t hash = hashFunction_(key);
+        Bucket& bucket = bucketAt(hash);
+        const auto& stored = TKeys::stored(key, hash);
+        for (unsigned int slot = 0; slot < HashTries; ++slot)
+        {
+            if (isLive(bucket, slot) && bucket.keys[slot] == stored)
+            {
+                promote(bucket, slot);
+                LOG ("get: key: " << key << " exist in slot: " << slot << std::endl);
+                return pointerTo(bucket, slot);
+            }
+        }
+        LOG("get: key: " << key << " not exist" << std::endl);
+        return PersistPointer(nullptr, nullptr);
+    }
+
+    /* Starts loading every line of the key's bucket and of its value slots. */
+    void prefetch(const TKey& key) const noexcept
+    {
+        const Bucket& bucket = bucketAt(hashFunction_(key));
+        non_std::internal::prefetch(&bucket, sizeof(Bucket));
+        non_std::internal::prefetch(&storage_.values()[index(bucket, 0)], HashTries * sizeof(TValue));
+    }
+
+    /* Copies the value out without locking it or updating its age: never writes the table, so any */
+    /* number of threads may probe() while no one modifies it. */
+    std::optional<TValue> probe(const TKey& key) const
+    {
+        const uint64_t hash = hashFunction_(key);
+        const Bucket& bucket = bucketAt(hash);
+        const auto& stored = TKeys::stored(key, hash);
+        for (unsigned int slot = 0; slot < HashTries; ++slot)
+        {
+            if (isLive(bucket, slot) && bucket.keys[slot] == stored)
             {
-                oldestAge = nodes_[bucket].age_;
-                oldestElem = &nodes_[bucket];
+                return storage_.values()[index(bucket, slot)];
             }
-            bucket = getBucket(bucket);
         }
-        create(*oldestElem, key, value);
+        return std::nullopt;
+    }
+
+    void store(const TKey& key, const TValue& value)
+    {
+        insertOrAssign(key, value);
     }
 
     pointer operator[](const TKey& key)
     {
         LOG ("operator[]: " << key << std::endl);
-        auto hash = hashFunction_(key);
-        auto bucket = hash & hashMask;
+        return tryEmplace(key).first;
+    }
 
-        Node* oldestElem = nullptr;
-        uint64_t oldestAge = 0ull - 1;
+    /* Constructs the value from args directly in the slot; does nothing when key is present. */
+    /* second is true when the value was inserted. */
+    template <typename... Args>
+    std::pair<pointer, bool> tryEmplace(const TKey& key, Args&&... args)
+    {
+        auto [bucket, slot, found, stored] = findSlot(key);
+        if (bucket == nullptr)
+        {
+            return {PersistPointer(nullptr, nullptr), false};
+        }
+        if (found)
+        {
+            promote(*bucket, slot);
+            return {pointerTo(*bucket, slot), false};
+        }
+        create(*bucket, slot, stored, std::forward<Args>(args)...);
+        return {pointerTo(*bucket, slot), true};
+    }
+
+    /* Same as tryEmplace(): an existing value is never replaced. */
+    template <typename... Args>
+    std::pair<pointer, bool> emplace(const TKey& key, Args&&... args)
+    {
+        return tryEmplace(key, std::forward<Args>(args)...);
+    }
 
-        for (std::decay<decltype(HashTries)>::type i = 0; i < HashTries; ++i)
+    /* Assigns val to an existing value (making it the youngest), otherwise constructs it in the slot. */
+    template <typename TVal>
+    std::pair<pointer, bool> insertOrAssign(const TKey& key, TVal&& val)
+    {
+        const TValue* incoming = nullptr;
+        if constexpr (std::is_same_v<std::decay_t<TVal>, TValue>)
+        {
+            incoming = &val;
+        }
+        auto [bucket, slot, found, stored] = findSlot(key, incoming);
+        if (bucket == nullptr)
         {
-            if ((nodes_[bucket].occupancy_ == Occupancy::occupied
-                 || nodes_[bucket].occupancy_ == Occupancy::locked) && nodes_[bucket].key_ == key)
+            return {PersistPointer(nullptr, nullptr), false};
+        }
+        if (found)
+        {
+            storage_.values()[index(*bucket, slot)] = std::forward<TVal>(val);
+            promote(*bucket, slot);
+            return {pointerTo(*bucket, slot), false};
+        }
+        create(*bucket, slot, stored, std::forward<TVal>(val));
+        return {pointerTo(*bucket, slot), true};
+    }
+private:
+    FixedSizeHashTableOpenHashingWithAge(Storage storage, uint16_t epoch, uint16_t generation)
+        : storage_(std::move(storage))
+        , bucketMask_(storage_.buckets().size() - 1)
+        , epoch_(epoch)
+        , generation_(generation)
+    {
+    }
+
+    struct Slot
+    {
+        Bucket* bucket;
+        unsigned int slot;
+        bool found;
+        StoredKey stored;
+    };
+
+    static std::size_t roundEntries(std::size_t entries) noexcept
+    {
+        return std::bit_ceil(std::max<std::size_t>(entries, HashTries));
+    }
+
+    static Occupancy occupancyOf(uint16_t meta) noexcept
+    {
+        return static_cast<Occupancy>(meta >> AgeBits);
+    }
+
+    static uint16_t ageOf(uint16_t meta) noexcept
+    {
+        return meta & AgeMask;
+    }
+
+    static uint16_t withOccupancy(uint16_t meta, Occupancy occupancy) noexcept
+    {
+        return static_cast<uint16_t>((static_cast<uint16_t>(occupancy) << AgeBits) | ageOf(meta));
+    }
+
+    static uint16_t withAge(uint16_t meta, uint16_t age) noexcept
+    {
+        return static_cast<uint16_t>((meta & ~AgeMask) | age);
+    }
+
+    Bucket& bucketAt(uint64_t hash) noexcept
+    {
+        return storage_.buckets()[hash & bucketMask_];
+    }
+
+    const Bucket& bucketAt(uint64_t hash) const noexcept
+    {
+        return storage_.buckets()[hash & bucketMask_];
+    }
+
+    std::size_t index(const Bucket& bucket, unsigned int slot) const noexcept
+    {
+        return static_cast<std::size_t>(&bucket - storage_.buckets().data()) * HashTries + slot;
+    }
+
+    PersistPointer pointerTo(Bucket& bucket, unsigned int slot) noexcept
+    {
+        return PersistPointer(&bucket.meta[slot], &storage_.values()[index(bucket, slot)], &bucket, &epoch_);
+    }
+
+    /* A bucket of an older epoch keeps only its locked entries. */
+    bool isLive(const Bucket& bucket, unsigned int slot) const noexcept
+    {
+        auto occupancy = occupancyOf(bucket.meta[slot]);
+        return occupancy == Occupancy::locked || (occupancy == Occupancy::occupied && bucket.epoch == epoch_);
+    }
+
+    /* Empties bucket for epoch, except for locked entries. */
+    static void refresh(Bucket& bucket, uint16_t epoch) noexcept
+    {
+        for (auto& meta : bucket.meta)
+        {
+            if (occupancyOf(meta) != Occupancy::locked)
             {
-                LOG ("operator[]: key: " << key << " exist in exist in bucket: " << bucket << std::endl);
-                return PersistPointer(&nodes_[bucket]);
+                meta = 0;
             }
-            if (nodes_[bucket].occupancy_ == Occupancy::free)
+        }
+        bucket.epoch = epoch;
+    }
+
+    /* Larger is a better victim. */
+    uint16_t staleness(uint16_t meta) const noexcept
+    {
+        if constexpr (std::is_same_v<TAging, AgeByGeneration>)
+        {
+            return (generation_ - ageOf(meta)) & AgeMask;
+        }
+        else
+        {
+            return ageOf(meta);
+        }
+    }
+
+    /* Makes slot the most recently used: live entries younger than it age by one. */
+    /* With generations, tags it with the current generation unless it already has it. */
+    void promote(Bucket& bucket, unsigned int slot) noexcept
+    {
+        if constexpr (std::is_same_v<TAging, AgeByGeneration>)
+        {
+            if (ageOf(bucket.meta[slot]) != generation_)
+            {
+                bucket.meta[slot] = withAge(bucket.meta[slot], generation_);
+            }
+            return;
+        }
+        const uint16_t age = isLive(bucket, slot) ? ageOf(bucket.meta[slot]) : AgeMask;
+        for (unsigned int other = 0; other < HashTries; ++other)
+        {
+            if (other != slot && isLive(bucket, other) && ageOf(bucket.meta[other]) < age)
+            {
+                bucket.meta[other] = withAge(bucket.meta[other], ageOf(bucket.meta[other]) + 1);
+            }
+        }
+        bucket.meta[slot] = withAge(bucket.meta[slot], 0);
+    }
+
+    /* Slot holding key (found is true), or the slot a new key shall take: a free one, otherwise */
+    /* a deleted one, otherwise the unlocked one TReplacement picks. nullptr when all are locked. */
+    Slot findSlot(const TKey& key, const TValue* incoming = nullptr)
+    {
+        const uint64_t hash = hashFunction_(key);
+        Bucket& bucket = bucketAt(hash);
+        const auto& stored = TKeys::stored(key, hash);
+        if (bucket.epoch != epoch_)
+        {
+            refresh(bucket, epoch_);
+        }
+
+        int freeSlot = -1;
+        ReplacementCandidate<TValue> candidates[HashTries];
+        std::size_t count = 0;
+        for (unsigned int slot = 0; slot < HashTries; ++slot)
+        {
+            const auto occupancy = occupancyOf(bucket.meta[slot]);
+            if ((occupancy == Occupancy::occupied || occupancy == Occupancy::locked) && bucket.keys[slot] == stored)
             {
-                LOG ("operator[]: key: " << key << " will be put into bucket as this is free: " << bucket << std::endl);
-                create(nodes_[bucket], key, TValue{});
-                return PersistPointer(&nodes_[bucket]);
+                LOG ("findSlot: key: " << key << " exist in slot: " << slot << std::endl);
+                return {&bucket, slot, true, stored};
             }
-            if (nodes_[bucket].occupancy_ == Occupancy::locked)
+            if (occupancy == Occupancy::free
+                && (freeSlot < 0 || occupancyOf(bucket.meta[freeSlot]) == Occupancy::deleted))
             {
-                bucket = getBucket(bucket);
-                continue;
+                freeSlot = static_cast<int>(slot);
             }
-            if (nodes_[bucket].occupancy_ == Occupancy::deleted)
+            else if (occupancy == Occupancy::deleted && freeSlot < 0)
             {
-                LOG ("operator[]: key: " << key << " conditionally may be put into bucket: " << bucket << " as this is free. " << std::endl);
-                oldestElem = &nodes_[bucket];
-                oldestAge = 0;
-                bucket = getBucket(bucket);
-                continue;
+                freeSlot = static_cast<int>(slot);
             }
-            if (nodes_[bucket].age_ < oldestAge)
+            else if (occupancy == Occupancy::occupied)
             {
-                LOG ("operator[]: key: " << key << " conditionally may be put into bucket: " << bucket << " Its age is: " << nodes_[bucket].age_ << std::endl);
-                oldestAge = nodes_[bucket].age_;
-                oldestElem = &nodes_[bucket];
+                candidates[count++] = {slot, staleness(bucket.meta[slot]), &storage_.values()[index(bucket, slot)]};
             }
-            bucket = getBucket(bucket);
         }
-        create(*oldestElem, key, TValue{});
-        return PersistPointer(oldestElem);
+        if (freeSlot >= 0)
+        {
+            LOG ("findSlot: key: " << key << " will be put into free slot: " << freeSlot << std::endl);
+            return {&bucket, static_cast<unsigned int>(freeSlot), false, stored};
+        }
+        if (count == 0)
+        {
+            return {nullptr, 0, false, stored};
+        }
+        const auto victim = candidates[TReplacement::victim(std::span<const ReplacementCandidate<TValue>>(candidates, count), incoming, hash)].slot;
+        LOG ("findSlot: key: " << key << " replaces slot: " << victim << std::endl);
+        return {&bucket, victim, false, stored};
     }
-private:
-    void create(Node& node, const TKey& key, const TValue& val)
+
+    template <typename... Args>
+    void create(Bucket& bucket, unsigned int slot, const StoredKey& key, Args&&... args)
     {
-        node.key_ = key;
-        node.value_ = val;
-        node.age_ = ++age_;
-        node.occupancy_ = Occupancy::occupied;
+        TValue& value = storage_.values()[index(bucket, slot)];
+        bucket.keys[slot] = key;
+        if constexpr (std::is_nothrow_constructible_v<TValue, Args...>)
+        {
+            std::destroy_at(&value);
+            std::construct_at(&value, std::forward<Args>(args)...);
+        }
+        else
+        {
+            value = TValue(std::forward<Args>(args)...);
+        }
+        // A replaced entry keeps its age until promoted, so entries younger than it age by one.
+        if (occupancyOf(bucket.meta[slot]) != Occupancy::occupied)
+        {
+            bucket.meta[slot] = withAge(0, AgeMask);
+        }
+        bucket.meta[slot] = withOccupancy(bucket.meta[slot], Occupancy::occupied);
+        promote(bucket, slot);
     }
 
-    std::decay_t<decltype(Hash())> hashFunction_;
-    std::vector<Node> nodes_;
-    uint64_t age_ = 0u;
-    uint64_t hashMask = (1u  << 21u) - 1;
+    /* mutable: probe() and prefetch() are const, Hash::operator() need not be. */
+    mutable std::decay_t<decltype(Hash())> hashFunction_;
+    Storage storage_;
+    uint64_t bucketMask_;
+    uint16_t epoch_ = 1;
+    uint16_t generation_ = 0;
 };
 
 }  // namespace non_std::containers
@@ -0,0 +1,262 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <stdint.h>
+#include <type_traits>
+#include <utility>
+#include <non_std/internal/ControlGroup.hpp>
+#include <non_std/internal/ZeroedArray.hpp>
+#include "Hash.hpp"
+#include "Traits.hpp"
+
+namespace non_std::containers
+{
+
+/*
+Open addressing hash map with the get/operator[]/store surface of HashMap.
+1. Slots are split into groups of 16. Every slot has a one-byte tag (7 bits of the hash) in a
+   separate control array, so a lookup compares a whole group of tags at once (SSE2, scalar
+   fallback) and touches a key only when its tag matches. No pointer chasing.
+2. THashWidth is the initial width. The table doubles (full rehash) once it is 7/8 full.
+3. Unlike HashMap's, returned pointers are invalidated by any insert which grows the table.
+*/
+template<typename TValue, typename TKey, unsigned char THashWidth, typename Hash = DefaultHash<TKey>>
+class FlatHashMap
+{
+public:
+    constexpr static NeverOverwriteTag OverwriteCategory {};
+    using pointer = TValue*;
+private:
+    using Group = non_std::internal::ControlGroup;
+
+    struct Slot
+    {
+        TKey key;
+        TValue val;
+
+        template <typename... Args>
+        Slot(const TKey &keyIn, Args&&... args)
+                : key(keyIn), val(std::forward<Args>(args)...)
+        {}
+    };
+
+public:
+    FlatHashMap()
+        : control_(std::max<std::size_t>(std::size_t(1) << THashWidth, Group::Width))
+        , slots_(allocateSlots(control_.size()))
+    {
+    }
+
+    FlatHashMap(const FlatHashMap &) = delete;
+    FlatHashMap &operator=(const FlatHashMap &) = delete;
+
+    FlatHashMap(FlatHashMap &&in) noexcept
+        : hashFunction_(std::move(in.hashFunction_))
+        , control_(std::move(in.control_))
+        , slots_(std::exchange(in.slots_, nullptr))
+        , size_(std::exchange(in.size_, 0))
+    {
+    }
+
+    FlatHashMap &operator=(FlatHashMap &&in) noexcept
+    {
+        if (this != &in)
+        {
+            destroyAll();
+            freeSlots(slots_);
+            hashFunction_ = std::move(in.hashFunction_);
+            control_ = std::move(in.control_);
+            slots_ = std::exchange(in.slots_, nullptr);
+            size_ = std::exchange(in.size_, 0);
+        }
+        return *this;
+    }
+
+    ~FlatHashMap()
+    {
+        destroyAll();
+        freeSlots(slots_);
+    }
+
+    void clear() noexcept
+    {
+        destroyAll();
+        std::fill(control_.begin(), control_.end(), Group::Empty);
+        size_ = 0;
+    }
+
+    std::size_t size() const noexcept
+    {
+        return size_;
+    }
+
+    std::size_t bucketCount() const noexcept
+    {
+        return control_.size();
+    }
+
+    TValue* get(const TKey key) noexcept
+    {
+        Slot* slot = find(key, hashFunction_(key));
+        return slot != nullptr ? &(slot->val) : nullptr;
+    }
+
+    // Missing key gets a value initialized value.
+    TValue* operator[](const TKey key)
+    {
+        return tryEmplace(key).first;
+    }
+
+    TValue *store(const TKey key, TValue val)
+    {
+        return insertOrAssign(key, std::move(val)).first;
+    }
+
+    // Constructs the value from args directly in a free slot; does nothing when key is present.
+    // second is true when the value was inserted.
+    template <typename... Args>
+    std::pair<TValue*, bool> tryEmplace(const TKey key, Args&&... args)
+    {
+        auto hash = hashFunction_(key);
+        if (Slot* slot = find(key, hash))
+        {
+            return {&(slot->val), false};
+        }
+        return {&(insert(hash, key, std::forward<Args>(args)...)->val), true};
+    }
+
+    // Same as tryEmplace(): an existing value is never replaced.
+    template <typename... Args>
+    std::pair<TValue*, bool> emplace(const TKey key, Args&&... args)
+    {
+        return tryEmplace(key, std::forward<Args>(args)...);
+    }
+
+    // Assigns val to an existing value, otherwise constructs it from val in a free slot.
+    template <typename TVal>
+    std::pair<TValue*, bool> insertOrAssign(const TKey key, TVal&& val)
+    {
+        auto hash = hashFunction_(key);
+        if (Slot* slot = find(key, hash))
+        {
+            slot->val = std::forward<TVal>(val);
+            return {&(slot->val), false};
+        }
+        return {&(insert(hash, key, std::forward<TVal>(val))->val), true};
+    }
+
+private:
+    static Slot* allocateSlots(std::size_t count)
+    {
+        return static_cast<Slot*>(::operator new(count * sizeof(Slot), std::align_val_t(alignof(Slot))));
+    }
+
+    static void freeSlots(Slot* slots) noexcept
+    {
+        ::operator delete(slots, std::align_val_t(alignof(Slot)));
+    }
+
+    static bool isFull(uint8_t control) noexcept
+    {
+        return (control & Group::Full) != 0;
+    }
+
+    // Groups are probed triangularly (+1, +2, +3, ...), which visits every group of a power of two table.
+    Slot* find(const TKey &key, uint64_t hash) noexcept
+    {
+        const auto tag = Group::tag(hash);
+        const auto groupMask = control_.size() / Group::Width - 1;
+        auto group = (hash >> 7) & groupMask;
+        for (std::size_t step = 1;; ++step)
+        {
+            Group controls(&control_[group * Group::Width]);
+            for (auto match = controls.match(tag); match != 0; match &= match - 1)
+            {
+                Slot& slot = slots_[group * Group::Width + std::countr_zero(match)];
+                if (slot.key == key)
+                {
+                    return &slot;
+                }
+            }
+            if (controls.matchEmpty() != 0)
+            {
+                return nullptr;
+            }
+            group = (group + step) & groupMask;
+        }
+    }
+
+    std::size_t findEmpty(uint64_t hash) noexcept
+    {
+        const auto groupMask = control_.size() / Group::Width - 1;
+        auto group = (hash >> 7) & groupMask;
+        for (std::size_t step = 1;; ++step)
+        {
+            if (auto empty = Group(&control_[group * Group::Width]).matchEmpty())
+            {
+                return group * Group::Width + std::countr_zero(empty);
+            }
+            group = (group + step) & groupMask;
+        }
+    }
+
+    template <typename... Args>
+    Slot* insert(uint64_t hash, const TKey &key, Args&&... args)
+    {
+        if (size_ + 1 > control_.size() - control_.size() / 8)
+        {
+            rehash(control_.size() * 2);
+        }
+        auto index = findEmpty(hash);
+        Slot* slot = std::construct_at(&slots_[index], key, std::forward<Args>(args)...);
+        control_[index] = Group::tag(hash);
+        ++size_;
+        return slot;
+    }
+
+    void rehash(std::size_t capacity)
+    {
+        auto oldControl = std::exchange(control_, Controls(capacity));
+        Slot* oldSlots = std::exchange(slots_, allocateSlots(capacity));
+        for (std::size_t i = 0; i < oldControl.size(); ++i)
+        {
+            if (isFull(oldControl[i]))
+            {
+                Slot& slot = oldSlots[i];
+                auto hash = hashFunction_(slot.key);
+                auto index = findEmpty(hash);
+                std::construct_at(&slots_[index], std::move(slot));
+                control_[index] = Group::tag(hash);
+                std::destroy_at(&slot);
+            }
+        }
+        freeSlots(oldSlots);
+    }
+
+    void destroyAll() noexcept
+    {
+        if constexpr (!std::is_trivially_destructible_v<Slot>)
+        {
+            for (std::size_t i = 0; i < control_.size(); ++i)
+            {
+                if (isFull(control_[i]))
+                {
+                    std::destroy_at(&slots_[i]);
+                }
+            }
+        }
+    }
+
+    using Controls = non_std::internal::ZeroedArray<uint8_t>;
+
+    Hash hashFunction_;
+    Controls control_;
+    Slot* slots_;
+    std::size_t size_ = 0;
+};
+
+}  // namespace non_std::containers
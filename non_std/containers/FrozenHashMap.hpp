@@ -0,0 +1,335 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <numeric>
+#include <span>
+#include <stdexcept>
+#include <stdint.h>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <non_std/internal/MappedFile.hpp>
+#include "Hash.hpp"
+#include "HashMap.hpp"
+
+#ifdef _MSC_VER
+    #include <intrin.h>
+#endif // _MSC_VER
+
+namespace non_std::containers
+{
+
+/*
+Read only map built once (e.g. by freeze() from a HashMap) into one flat blob:
+header, one 32-bit pilot per bucket of ~KeysPerBucket keys, remap table, then exactly size() entries.
+1. Minimal perfect hash (hash and displace, as in CHD/PTHash): the bucket pilot of a key moves it to
+   a position no other key uses. A lookup reads one pilot and one entry; a key which is not in the
+   map is rejected by comparing it with the key stored in that entry.
+2. Pilots are searched over size() * 1024 / SearchLoad positions, so the last buckets placed find free
+   positions quickly. The few keys landing past size() are remapped to the unused entries below it.
+3. The blob holds no pointers: save() writes it as is and open() mmaps it back, checking only the header.
+4. TKey and TValue must be trivially copyable, and Hash must give the same results in the process
+   which opens the file as in the one which built it.
+5. Build fails (std::invalid_argument) when two keys have the same 64-bit hash, e.g. duplicated keys.
+6. A moved-from map finds nothing and must not be saved.
+*/
+template<typename TValue, typename TKey, typename Hash = DefaultHash<TKey>>
+class FrozenHashMap
+{
+    static_assert(std::is_trivially_copyable_v<TKey> && std::is_trivially_copyable_v<TValue>);
+
+    struct Entry
+    {
+        TKey key;
+        TValue val;
+    };
+    static_assert(alignof(Entry) <= alignof(std::max_align_t));
+
+    struct Header
+    {
+        uint64_t magic;
+        uint64_t keySize;
+        uint64_t valueSize;
+        uint64_t size;
+        uint64_t buckets;
+        uint64_t positions;
+        uint64_t entriesOffset;
+        uint64_t bytes;
+    };
+
+    static constexpr uint64_t Magic = 0x315a52464d48534eull; // "NSHMFRZ1"
+
+public:
+    static constexpr std::size_t KeysPerBucket = 4;
+    // size() / positions searched by the build, as a fraction of 1024.
+    static constexpr std::size_t SearchLoad = 1014;
+
+    FrozenHashMap()
+        : FrozenHashMap(std::span<const std::pair<TKey, TValue>>())
+    {
+    }
+
+    explicit FrozenHashMap(std::span<const std::pair<TKey, TValue>> entries)
+    {
+        build(entries);
+    }
+
+    template <unsigned char THashWidth, typename THash>
+    static FrozenHashMap freeze(const HashMap<TValue, TKey, THashWidth, THash>& map)
+    {
+        std::vector<std::pair<TKey, TValue>> entries;
+        entries.reserve(map.size());
+        map.forEach([&entries](const TKey& key, const TValue& val) { entries.emplace_back(key, val); });
+        return FrozenHashMap(entries);
+    }
+
+    // Maps a file written by save(). Throws std::runtime_error when it was built for other types.
+    static FrozenHashMap open(const std::string& path)
+    {
+        return FrozenHashMap(non_std::internal::MappedFile(path));
+    }
+
+    FrozenHashMap(const FrozenHashMap&) = delete;
+    FrozenHashMap& operator=(const FrozenHashMap&) = delete;
+
+    FrozenHashMap(FrozenHashMap&& other) noexcept
+    {
+        swap(other);
+    }
+
+    FrozenHashMap& operator=(FrozenHashMap&& other) noexcept
+    {
+        if (this != &other)
+        {
+            FrozenHashMap(std::move(other)).swap(*this);
+        }
+        return *this;
+    }
+
+    void swap(FrozenHashMap& other) noexcept
+    {
+        std::swap(hashFunction_, other.hashFunction_);
+        std::swap(owned_, other.owned_);
+        file_.swap(other.file_);
+        std::swap(header_, other.header_);
+        std::swap(pilots_, other.pilots_);
+        std::swap(remap_, other.remap_);
+        std::swap(entries_, other.entries_);
+        std::swap(size_, other.size_);
+        std::swap(buckets_, other.buckets_);
+        std::swap(positions_, other.positions_);
+    }
+
+    void save(const std::string& path) const
+    {
+        non_std::internal::writeFile(path, header_, header_->bytes);
+    }
+
+    std::size_t size() const noexcept
+    {
+        return size_;
+    }
+
+    const TValue* get(const TKey& key) const noexcept
+    {
+        if (size_ == 0)
+        {
+            return nullptr;
+        }
+        auto hash = hashFunction_(key);
+        auto pos = position(hash, pilots_[bucketOf(hash, buckets_)], positions_);
+        if (pos >= size_)
+        {
+            pos = remap_[pos - size_];
+        }
+        const Entry& entry = entries_[pos];
+        return entry.key == key ? &entry.val : nullptr;
+    }
+
+private:
+    explicit FrozenHashMap(non_std::internal::MappedFile file)
+        : file_(std::move(file))
+    {
+        const auto* header = reinterpret_cast<const Header*>(file_.data());
+        if (file_.size() < sizeof(Header) || header->magic != Magic || header->keySize != sizeof(TKey)
+            || header->valueSize != sizeof(TValue) || header->bytes != file_.size()
+            || header->positions < header->size
+            || header->entriesOffset != entriesOffset(header->buckets, header->positions - header->size)
+            || header->bytes != header->entriesOffset + header->size * sizeof(Entry))
+        {
+            throw std::runtime_error("FrozenHashMap: file does not hold a map of these types");
+        }
+        attach(file_.data());
+    }
+
+    static uint64_t mulHigh(uint64_t a, uint64_t b) noexcept
+    {
+#ifdef _MSC_VER
+        return __umulh(a, b);
+#else
+        return static_cast<uint64_t>((static_cast<unsigned __int128>(a) * b) >> 64);
+#endif // _MSC_VER
+    }
+
+    // Bucket from the low half of the hash, entry from the whole hash mixed with the pilot, so
+    // trying another pilot moves the keys of one bucket independently of each other.
+    static uint64_t bucketOf(uint64_t hash, uint64_t buckets) noexcept
+    {
+        return ((hash & 0xffffffffull) * buckets) >> 32;
+    }
+
+    static uint64_t position(uint64_t hash, uint32_t pilot, uint64_t positions) noexcept
+    {
+        return mulHigh(mix64(hash ^ (pilot * 0x9e3779b97f4a7c15ull)), positions);
+    }
+
+    static std::size_t entriesOffset(std::size_t buckets, std::size_t remapped) noexcept
+    {
+        auto end = sizeof(Header) + (buckets + remapped) * sizeof(uint32_t);
+        return (end + alignof(Entry) - 1) / alignof(Entry) * alignof(Entry);
+    }
+
+    void attach(const unsigned char* blob) noexcept
+    {
+        header_ = reinterpret_cast<const Header*>(blob);
+        pilots_ = reinterpret_cast<const uint32_t*>(blob + sizeof(Header));
+        remap_ = pilots_ + header_->buckets;
+        entries_ = reinterpret_cast<const Entry*>(blob + header_->entriesOffset);
+        size_ = header_->size;
+        buckets_ = header_->buckets;
+        positions_ = header_->positions;
+    }
+
+    void build(std::span<const std::pair<TKey, TValue>> entries)
+    {
+        const std::size_t size = entries.size();
+        const std::size_t buckets = size / KeysPerBucket + 1;
+        const std::size_t positions = size * 1024 / SearchLoad + 1;
+        const std::size_t offset = entriesOffset(buckets, positions - size);
+        const std::size_t bytes = offset + size * sizeof(Entry);
+        owned_ = std::make_unique_for_overwrite<std::max_align_t[]>((bytes + sizeof(std::max_align_t) - 1) / sizeof(std::max_align_t));
+        auto* blob = reinterpret_cast<unsigned char*>(owned_.get());
+        // Value initialization would skip the padding inside max_align_t; unused remap entries and save() need zeros.
+        std::memset(blob, 0, bytes);
+        auto* header = reinterpret_cast<Header*>(blob);
+        *header = Header{Magic, sizeof(TKey), sizeof(TValue), size, buckets, positions, offset, bytes};
+        auto* pilots = reinterpret_cast<uint32_t*>(blob + sizeof(Header));
+        auto* remap = pilots + buckets;
+        auto* slots = reinterpret_cast<Entry*>(blob + header->entriesOffset);
+
+        std::vector<uint64_t> hashes(size);
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            hashes[i] = hashFunction_(entries[i].first);
+        }
+        {
+            auto sorted = hashes;
+            std::sort(sorted.begin(), sorted.end());
+            if (std::adjacent_find(sorted.begin(), sorted.end()) != sorted.end())
+            {
+                throw std::invalid_argument("FrozenHashMap: two keys have the same hash");
+            }
+        }
+
+        // Keys grouped by bucket (counting sort), buckets placed largest first while most entries are free.
+        std::vector<uint32_t> bucketBegin(buckets + 1, 0);
+        for (auto hash : hashes)
+        {
+            ++bucketBegin[bucketOf(hash, buckets) + 1];
+        }
+        std::partial_sum(bucketBegin.begin(), bucketBegin.end(), bucketBegin.begin());
+        std::vector<uint32_t> keysByBucket(size);
+        {
+            auto next = bucketBegin;
+            for (std::size_t i = 0; i < size; ++i)
+            {
+                keysByBucket[next[bucketOf(hashes[i], buckets)]++] = static_cast<uint32_t>(i);
+            }
+        }
+        std::vector<uint32_t> order(buckets);
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&bucketBegin](uint32_t a, uint32_t b) {
+            return bucketBegin[a + 1] - bucketBegin[a] > bucketBegin[b + 1] - bucketBegin[b];
+        });
+
+        std::vector<bool> taken(positions, false);
+        std::vector<uint64_t> found;
+        for (auto bucket : order)
+        {
+            const auto keys = std::span<const uint32_t>(keysByBucket).subspan(
+                bucketBegin[bucket], bucketBegin[bucket + 1] - bucketBegin[bucket]);
+            if (keys.empty())
+            {
+                continue;
+            }
+            uint32_t pilot = 0;
+            while (!tryPilot(keys, hashes, pilot, taken, found))
+            {
+                if (++pilot == 0)
+                {
+                    throw std::invalid_argument("FrozenHashMap: no pilot found");
+                }
+            }
+            pilots[bucket] = pilot;
+            for (auto pos : found)
+            {
+                taken[pos] = true;
+            }
+        }
+
+        // Every taken position past size has a free entry below size to move to.
+        for (std::size_t pos = size, free = 0; pos < positions; ++pos)
+        {
+            if (taken[pos])
+            {
+                while (taken[free])
+                {
+                    ++free;
+                }
+                remap[pos - size] = static_cast<uint32_t>(free++);
+            }
+        }
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            auto hash = hashes[i];
+            auto pos = position(hash, pilots[bucketOf(hash, buckets)], positions);
+            auto* slot = &slots[pos >= size ? remap[pos - size] : pos];
+            slot->key = entries[i].first;
+            slot->val = entries[i].second;
+        }
+        attach(blob);
+    }
+
+    bool tryPilot(std::span<const uint32_t> keys, const std::vector<uint64_t>& hashes, uint32_t pilot,
+                  const std::vector<bool>& taken, std::vector<uint64_t>& found) const
+    {
+        found.clear();
+        for (auto key : keys)
+        {
+            auto pos = position(hashes[key], pilot, taken.size());
+            if (taken[pos] || std::find(found.begin(), found.end(), pos) != found.end())
+            {
+                return false;
+            }
+            found.push_back(pos);
+        }
+        return true;
+    }
+
+    Hash hashFunction_;
+    std::unique_ptr<std::max_align_t[]> owned_;
+    non_std::internal::MappedFile file_;
+    const Header* header_ = nullptr;
+    const uint32_t* pilots_ = nullptr;
+    const uint32_t* remap_ = nullptr;
+    const Entry* entries_ = nullptr;
+    std::size_t size_ = 0;
+    std::size_t buckets_ = 0;
+    std::size_t positions_ = 0;
+};
+
+}  // namespace non_std::containers
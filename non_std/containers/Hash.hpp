@@ -0,0 +1,38 @@
+#pragma once
+
+#include <functional>
+#include <stdint.h>
+#include <type_traits>
+
+namespace non_std::containers
+{
+
+// Finalizer of MurmurHash3: every input bit affects every output bit, so keys that differ only in
+// high bits (or share low bit patterns) still spread over all buckets.
+constexpr uint64_t mix64(uint64_t in) noexcept
+{
+    in ^= in >> 33;
+    in *= 0xff51afd7ed558ccdull;
+    in ^= in >> 33;
+    in *= 0xc4ceb9fe1a85ec53ull;
+    in ^= in >> 33;
+    return in;
+}
+
+template <typename TKey>
+struct DefaultHash
+{
+    uint64_t operator()(const TKey& key) const noexcept
+    {
+        if constexpr (std::is_integral_v<TKey> || std::is_enum_v<TKey>)
+        {
+            return mix64(static_cast<uint64_t>(key));
+        }
+        else
+        {
+            return mix64(std::hash<TKey>{}(key));
+        }
+    }
+};
+
+}  // namespace non_std::containers
@@ -1,18 +1,45 @@
 #pragma once
 
-#include <vector>
+#include <algorithm>
 #include <cstdint>
+#include <memory>
+#include <span>
+#include <type_traits>
+#include <utility>
 #include <non_std/PoolAlocator.hpp>
+#include <non_std/internal/Prefetch.hpp>
+#include <non_std/internal/ZeroedArray.hpp>
+#include "Hash.hpp"
 #include "Traits.hpp"
 
 namespace non_std::containers
 {
 
-template<typename TValue, typename TKey, unsigned char THashWidth>
+/*
+Chained hash map with nodes taken from PoolAllocator.
+1. THashWidth is the initial bucket count (1 << THashWidth).
+2. Once there are more nodes than buckets, the bucket table doubles. Buckets are migrated to the new
+   table a few per operation, so no single insert pays for a full rehash. Until migration finishes a
+   key lives in the old table if its old bucket is not migrated yet, in the new table otherwise.
+   Bucket tables are ZeroedArrays, so starting a resize does not write the new table either.
+   The PagePolicy given at construction places large bucket tables and the node slabs.
+3. Every key is stored once; store() overwrites. erase() returns the node to the pool, where the next
+   insert reuses it, so a sliding key set runs at steady memory.
+4. forEach() walks pool slabs one after another instead of bucket chains; entries of one slab come in
+   address order, the slabs in no particular order.
+5. getBatch() overlaps the cache misses of independent lookups: bucket heads of a whole group of
+   keys are prefetched, then their first nodes, then the chains are walked.
+6. prefetch(key) starts loading the bucket head of a key that will be looked up later; the node
+   itself is still fetched by the lookup.
+*/
+template<typename TValue, typename TKey, unsigned char THashWidth, typename Hash = DefaultHash<TKey>>
 class HashMap
 {
 public:
     constexpr static NeverOverwriteTag OverwriteCategory {};
+    constexpr static std::size_t MaxLoadFactor = 1;
+    constexpr static std::size_t MigrationStep = 2;
+    constexpr static std::size_t LookupGroup = 32;
     using pointer = TValue*;
 private:
     struct Node
@@ -21,41 +48,53 @@ private:
         TValue val;
         Node *next;
 
-        Node(const TKey &keyIn, const TValue &valIn, Node *nextIn) noexcept
-                : key(keyIn), val(valIn), next(nextIn)
+        template <typename... Args>
+        Node(const TKey &keyIn, Node *nextIn, Args&&... args)
+                : key(keyIn), val(std::forward<Args>(args)...), next(nextIn)
         {}
-
-        Node(const TKey &keyIn, TValue &&valIn, Node *nextIn) noexcept
-                : key(keyIn), val(std::move(valIn)), next(nextIn)
-        {}
-
-        ~Node() noexcept
-        {
-            delete next;
-        }
     };
 
 public:
     HashMap()
-        : table(1 << THashWidth, nullptr)
+        : table(1 << THashWidth)
+    {
+    }
+
+    explicit HashMap(const non_std::internal::PagePolicy& pages)
+        : allocator_(PoolAllocatorTrimPolicy{}, pages)
+        , table(1 << THashWidth, pages)
+        , pages_(pages)
     {
     }
 
     HashMap(const HashMap &) = delete;
     HashMap &operator=(const HashMap &in) = delete;
 
-    HashMap &operator=(HashMap &&in)
+    HashMap &operator=(HashMap &&in) noexcept
     {
-        clear();
-        this->table = in.table;
-        in.table = {};
+        if (this != &in)
+        {
+            destroyAll();
+            allocator_ = std::move(in.allocator_);
+            table = std::move(in.table);
+            oldTable = std::move(in.oldTable);
+            migratedBuckets_ = std::exchange(in.migratedBuckets_, 0);
+            size_ = std::exchange(in.size_, 0);
+            hashFunction_ = std::move(in.hashFunction_);
+            pages_ = in.pages_;
+        }
         return *this;
     }
 
-    HashMap(HashMap &&in)
+    HashMap(HashMap &&in) noexcept
+        : hashFunction_(std::move(in.hashFunction_))
+        , allocator_(std::move(in.allocator_))
+        , table(std::move(in.table))
+        , oldTable(std::move(in.oldTable))
+        , migratedBuckets_(std::exchange(in.migratedBuckets_, 0))
+        , size_(std::exchange(in.size_, 0))
+        , pages_(in.pages_)
     {
-        this->table = in.table;
-        in.table = {};
     }
 
     void clear() noexcept
@@ -65,56 +104,317 @@ public:
                 elem = nullptr;
             }
         }
+        oldTable = {};
+        migratedBuckets_ = 0;
+        size_ = 0;
+        destroyAll();
         allocator_.clearAll();
     }
 
     ~HashMap()
     {
-        // No need to clear POD types. Allocator does it for us.
+        // Memory goes with the allocator; only non trivial nodes need destruction.
+        destroyAll();
+    }
+
+    std::size_t size() const noexcept
+    {
+        return size_;
+    }
+
+    std::size_t bucketCount() const noexcept
+    {
+        return table.size();
+    }
+
+    bool isResizing() const noexcept
+    {
+        return !oldTable.empty();
     }
 
     TValue* get(const TKey key) noexcept
     {
-        auto index = key & hashMask;
-        Node *node = table[index];
-        while (node != nullptr) {
-            if (node->key == key) {
-                return &(node->val);
+        migrate(MigrationStep);
+        Node *node = find(key, hashFunction_(key));
+        return node != nullptr ? &(node->val) : nullptr;
+    }
+
+    // Unlike get(), does not advance a pending resize, so concurrent calls on a shared map are safe.
+    const TValue* get(const TKey key) const noexcept
+    {
+        Node *node = find(key, hashFunction_(key));
+        return node != nullptr ? &(node->val) : nullptr;
+    }
+
+    // Non-binding hint, changes nothing: safe on a shared map like the const get().
+    void prefetch(const TKey key) const noexcept
+    {
+        non_std::internal::prefetch(&bucket(hashFunction_(key)));
+    }
+
+    // out[i] = get(keys[i]); out must be at least as long as keys.
+    void getBatch(std::span<const TKey> keys, std::span<TValue*> out) noexcept
+    {
+        migrate(MigrationStep);
+        uint64_t hashes[LookupGroup];
+        Node* heads[LookupGroup];
+        for (std::size_t begin = 0; begin < keys.size(); begin += LookupGroup)
+        {
+            const auto count = std::min(LookupGroup, keys.size() - begin);
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                hashes[i] = hashFunction_(keys[begin + i]);
+                non_std::internal::prefetch(&bucket(hashes[i]));
+            }
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                heads[i] = bucket(hashes[i]);
+                non_std::internal::prefetch(heads[i]);
+            }
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                Node *node = heads[i];
+                while (node != nullptr && !(node->key == keys[begin + i])) {
+                    node = node->next;
+                }
+                out[begin + i] = node != nullptr ? &(node->val) : nullptr;
             }
-            node = node->next;
         }
-        return nullptr;
     }
 
+    // Missing key gets a value initialized value.
     TValue* operator[](const TKey key)
     {
-        auto index = key & hashMask;
-        Node *node = table[index];
+        return tryEmplace(key).first;
+    }
+
+    TValue *store(const TKey key, TValue val)
+    {
+        return insertOrAssign(key, std::move(val)).first;
+    }
+
+    // Constructs the value from args directly in a new node; does nothing when key is present.
+    // second is true when the value was inserted.
+    template <typename... Args>
+    std::pair<TValue*, bool> tryEmplace(const TKey key, Args&&... args)
+    {
+        auto hash = hashFunction_(key);
+        if (Node *node = find(key, hash)) {
+            return {&(node->val), false};
+        }
+        return {&(insert(hash, key, std::forward<Args>(args)...)->val), true};
+    }
+
+    // Same as tryEmplace(): an existing value is never replaced.
+    template <typename... Args>
+    std::pair<TValue*, bool> emplace(const TKey key, Args&&... args)
+    {
+        return tryEmplace(key, std::forward<Args>(args)...);
+    }
+
+    // Assigns val to an existing value, otherwise constructs it from val in a new node.
+    template <typename TVal>
+    std::pair<TValue*, bool> insertOrAssign(const TKey key, TVal&& val)
+    {
+        auto hash = hashFunction_(key);
+        if (Node *node = find(key, hash)) {
+            node->val = std::forward<TVal>(val);
+            return {&(node->val), false};
+        }
+        return {&(insert(hash, key, std::forward<TVal>(val))->val), true};
+    }
+
+    // Like store() for every entry, but nodes are taken from the pool in batches.
+    void storeBulk(std::span<const std::pair<TKey, TValue>> entries)
+    {
+        constexpr std::size_t BatchSize = 256;
+        Node* nodes[BatchSize];
+        for (std::size_t begin = 0; begin < entries.size(); begin += BatchSize)
+        {
+            auto count = std::min(BatchSize, entries.size() - begin);
+            allocator_.allocateBulk(count, nodes);
+            std::size_t used = 0;
+            try {
+                for (std::size_t i = 0; i < count; ++i)
+                {
+                    const auto& [key, val] = entries[begin + i];
+                    auto hash = hashFunction_(key);
+                    if (Node *node = find(key, hash)) {
+                        node->val = val;
+                        continue;
+                    }
+                    Node *node = std::construct_at(nodes[used], key, nullptr, val);
+                    ++used;
+                    link(hash, node);
+                }
+            } catch (...) {
+                // As in insert(): nodes never constructed must not stay allocated for forEachAllocated().
+                allocator_.dealocateBulk(std::span<Node* const>(nodes + used, count - used));
+                throw;
+            }
+            if (used < count)
+            {
+                allocator_.dealocateBulk(std::span<Node* const>(nodes + used, count - used));
+            }
+        }
+    }
+
+    // Returns false when key is not in the map.
+    bool erase(const TKey key) noexcept
+    {
+        migrate(MigrationStep);
+        Node **link = &bucket(hashFunction_(key));
+        while (*link != nullptr) {
+            Node *node = *link;
+            if (node->key == key) {
+                *link = node->next;
+                std::destroy_at(node);
+                allocator_.dealocate(node);
+                --size_;
+                return true;
+            }
+            link = &(node->next);
+        }
+        return false;
+    }
+
+    // Calls f(const TKey&, TValue&) for every entry, in no particular order. f must not insert or erase.
+    template <typename F>
+    void forEach(F&& f)
+    {
+        allocator_.forEachAllocated([&f](Node* node) { f(std::as_const(node->key), node->val); });
+    }
+
+    template <typename F>
+    void forEach(F&& f) const
+    {
+        allocator_.forEachAllocated([&f](const Node* node) { f(node->key, node->val); });
+    }
+
+    PoolAllocatorStats allocatorStats() const noexcept
+    {
+        return allocator_.stats();
+    }
+
+    void setTrimPolicy(PoolAllocatorTrimPolicy policy)
+    {
+        allocator_.setTrimPolicy(policy);
+    }
+
+private:
+    Node* find(const TKey &key, uint64_t hash) const noexcept
+    {
+        Node *node = bucket(hash);
         while (node != nullptr) {
             if (node->key == key) {
-                return &(node->val);
+                return node;
             }
             node = node->next;
         }
-        node = allocator_.allocate();
-        std::construct_at(node, key, TValue{}, table[index]);
-        table[index] = node;
-        return &(table[index]->val);
+        return nullptr;
     }
 
-    TValue *store(const TKey key, const TValue val)
+    void destroyAll() noexcept
+    {
+        if constexpr (!std::is_trivially_destructible_v<Node>)
+        {
+            allocator_.forEachAllocated([](Node* node) { std::destroy_at(node); });
+        }
+    }
+
+    template <typename... Args>
+    Node* insert(uint64_t hash, const TKey& key, Args&&... args)
     {
-        auto index = key & hashMask;
         auto *node = allocator_.allocate();
-        std::construct_at(node, key, std::move(val), table[index]);
-        table[index] = node;
-        return &(table[index]->val);
+        try {
+            std::construct_at(node, key, nullptr, std::forward<Args>(args)...);
+        } catch (...) {
+            // forEachAllocated() would otherwise destroy a node which was never constructed.
+            allocator_.dealocate(node);
+            throw;
+        }
+        link(hash, node);
+        return node;
     }
 
-private:
+    void link(uint64_t hash, Node* node)
+    {
+        Node*& head = bucket(hash);
+        node->next = head;
+        head = node;
+        ++size_;
+        if (isResizing())
+        {
+            migrate(MigrationStep);
+        }
+        else if (size_ > table.size() * MaxLoadFactor)
+        {
+            startResize();
+        }
+    }
+
+    Node*& bucket(uint64_t hash) noexcept
+    {
+        return const_cast<Node*&>(std::as_const(*this).bucket(hash));
+    }
+
+    Node* const& bucket(uint64_t hash) const noexcept
+    {
+        if (isResizing())
+        {
+            auto oldIndex = hash & (oldTable.size() - 1);
+            if (oldIndex >= migratedBuckets_)
+            {
+                return oldTable[oldIndex];
+            }
+        }
+        return table[hash & (table.size() - 1)];
+    }
+
+    void startResize()
+    {
+        oldTable = std::exchange(table, Buckets(table.size() * 2, pages_));
+        migratedBuckets_ = 0;
+        migrate(MigrationStep);
+    }
+
+    // Moves up to `buckets` non-empty buckets to the new table, looking at no more than
+    // 16 * `buckets` old buckets in total. Old bucket i splits into new buckets i and i + old size,
+    // keeping chain order.
+    void migrate(std::size_t buckets) noexcept
+    {
+        const auto mask = table.size() - 1;
+        for (std::size_t visits = buckets * 16; buckets > 0 && visits > 0 && migratedBuckets_ < oldTable.size(); --visits)
+        {
+            const auto oldIndex = migratedBuckets_++;
+            Node* node = std::exchange(oldTable[oldIndex], nullptr);
+            buckets -= (node != nullptr);
+            Node** tails[2] = {&table[oldIndex], &table[oldIndex + oldTable.size()]};
+            while (node != nullptr)
+            {
+                Node* next = node->next;
+                auto& tail = tails[(hashFunction_(node->key) & mask) != oldIndex];
+                node->next = nullptr;
+                *tail = node;
+                tail = &node->next;
+                node = next;
+            }
+        }
+        if (migratedBuckets_ == oldTable.size() && !oldTable.empty())
+        {
+            oldTable = {};
+            migratedBuckets_ = 0;
+        }
+    }
+
+    Hash hashFunction_;
     PoolAllocator <Node> allocator_;
-    std::vector<Node *> table;
-    static constexpr uint64_t hashMask = (1 << THashWidth) - 1;
+    using Buckets = non_std::internal::ZeroedArray<Node*>;
+    Buckets table;
+    Buckets oldTable;
+    std::size_t migratedBuckets_ = 0;
+    std::size_t size_ = 0;
+    non_std::internal::PagePolicy pages_;
 };
 
 }  // namespace non_std::containers
@@ -0,0 +1,167 @@
+#pragma once
+
+#include <cstddef>
+#include <stdint.h>
+#include <utility>
+#include "Hash.hpp"
+#include "HashMap.hpp"
+#include "Traits.hpp"
+
+namespace non_std::containers
+{
+
+/*
+Capacity bounded cache with exact least recently used eviction.
+1. Entries live in HashMap nodes (so in its PoolAllocator) and are threaded on an intrusive recency
+   list. get/store/evict are O(1); once the cache is full every insert reuses the node of the entry
+   it evicts, so steady state traffic does not allocate.
+2. get(), operator[] and store() make the entry the most recent one.
+3. Returned pointers stay valid until the entry is evicted or erased.
+*/
+template<typename TValue, typename TKey, typename Hash = DefaultHash<TKey>>
+class LruCache
+{
+public:
+    constexpr static OverwriteOlderElements_Taq OverwriteCategory {};
+    using pointer = TValue*;
+private:
+    struct Entry
+    {
+        TValue val;
+        TKey key;
+        Entry *prev = nullptr;
+        Entry *next = nullptr;
+
+        template <typename... Args>
+        Entry(const TKey &keyIn, Args&&... args)
+                : val(std::forward<Args>(args)...), key(keyIn)
+        {}
+    };
+
+public:
+    explicit LruCache(std::size_t capacity)
+        : capacity_(capacity > 0 ? capacity : 1)
+    {
+    }
+
+    LruCache(const LruCache &) = delete;
+    LruCache &operator=(const LruCache &) = delete;
+
+    std::size_t size() const noexcept
+    {
+        return map_.size();
+    }
+
+    std::size_t capacity() const noexcept
+    {
+        return capacity_;
+    }
+
+    TValue* get(const TKey key) noexcept
+    {
+        Entry *entry = map_.get(key);
+        if (entry == nullptr) {
+            return nullptr;
+        }
+        touch(entry);
+        return &(entry->val);
+    }
+
+    // Missing key gets a value initialized value, evicting the least recent entry when full.
+    TValue* operator[](const TKey key)
+    {
+        return tryEmplace(key).first;
+    }
+
+    TValue* store(const TKey key, TValue val)
+    {
+        return insertOrAssign(key, std::move(val)).first;
+    }
+
+    template <typename... Args>
+    std::pair<TValue*, bool> tryEmplace(const TKey key, Args&&... args)
+    {
+        if (Entry *entry = map_.get(key)) {
+            touch(entry);
+            return {&(entry->val), false};
+        }
+        return {&(insert(key, std::forward<Args>(args)...)->val), true};
+    }
+
+    template <typename TVal>
+    std::pair<TValue*, bool> insertOrAssign(const TKey key, TVal&& val)
+    {
+        if (Entry *entry = map_.get(key)) {
+            entry->val = std::forward<TVal>(val);
+            touch(entry);
+            return {&(entry->val), false};
+        }
+        return {&(insert(key, std::forward<TVal>(val))->val), true};
+    }
+
+    bool erase(const TKey key) noexcept
+    {
+        Entry *entry = map_.get(key);
+        if (entry == nullptr) {
+            return false;
+        }
+        unlink(entry);
+        return map_.erase(key);
+    }
+
+    void clear() noexcept
+    {
+        map_.clear();
+        head_ = nullptr;
+        tail_ = nullptr;
+    }
+
+    PoolAllocatorStats allocatorStats() const noexcept
+    {
+        return map_.allocatorStats();
+    }
+
+private:
+    template <typename... Args>
+    Entry* insert(const TKey &key, Args&&... args)
+    {
+        if (map_.size() == capacity_) {
+            Entry *oldest = tail_;
+            unlink(oldest);
+            map_.erase(oldest->key);
+        }
+        Entry *entry = map_.tryEmplace(key, key, std::forward<Args>(args)...).first;
+        pushFront(entry);
+        return entry;
+    }
+
+    void touch(Entry *entry) noexcept
+    {
+        if (entry != head_) {
+            unlink(entry);
+            pushFront(entry);
+        }
+    }
+
+    void unlink(Entry *entry) noexcept
+    {
+        (entry->prev != nullptr ? entry->prev->next : head_) = entry->next;
+        (entry->next != nullptr ? entry->next->prev : tail_) = entry->prev;
+        entry->prev = nullptr;
+        entry->next = nullptr;
+    }
+
+    void pushFront(Entry *entry) noexcept
+    {
+        entry->next = head_;
+        (head_ != nullptr ? head_->prev : tail_) = entry;
+        head_ = entry;
+    }
+
+    HashMap<Entry, TKey, 10, Hash> map_;
+    Entry *head_ = nullptr;
+    Entry *tail_ = nullptr;
+    std::size_t capacity_;
+};
+
+}  // namespace non_std::containers
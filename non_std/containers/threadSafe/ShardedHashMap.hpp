@@ -0,0 +1,103 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <stdint.h>
+#include <utility>
+
+#include <non_std/containers/Hash.hpp>
+#include <non_std/containers/HashMap.hpp>
+
+namespace non_std::containers::thread_safe
+{
+
+/*
+Concurrent map: keys are split by the top TShardWidth bits of the remixed hash (Hash may be the
+identity, e.g. std::hash of an integer) over independent shards, each a HashMap (with its own
+PoolAllocator) behind a std::shared_mutex.
+1. Readers lock their shard shared, so they never wait for each other, only for a writer of the
+   same shard. Writers lock a single shard.
+2. Reads use the const HashMap::get(), which does not advance a resize, so shared readers never write.
+3. Values are returned by copy: no pointer into a shard outlives its lock.
+4. Shards are cache line aligned, so locks of neighbouring shards do not share a line.
+*/
+template <typename TValue, typename TKey, unsigned char TShardWidth = 6, typename Hash = DefaultHash<TKey>>
+class ShardedHashMap
+{
+    static_assert(TShardWidth > 0 && TShardWidth < 16);
+
+    struct alignas(64) Shard
+    {
+        mutable std::shared_mutex mutex;
+        HashMap<TValue, TKey, 10, Hash> map;
+    };
+
+public:
+    static constexpr std::size_t Shards = std::size_t(1) << TShardWidth;
+
+    ShardedHashMap() = default;
+    ShardedHashMap(const ShardedHashMap&) = delete;
+    ShardedHashMap& operator=(const ShardedHashMap&) = delete;
+
+    std::optional<TValue> get(const TKey& key) const
+    {
+        const Shard& shard = shardOf(key);
+        std::shared_lock lk(shard.mutex);
+        if (const TValue* val = std::as_const(shard.map).get(key))
+        {
+            return *val;
+        }
+        return std::nullopt;
+    }
+
+    void store(const TKey& key, TValue val)
+    {
+        Shard& shard = shardOf(key);
+        std::lock_guard lk(shard.mutex);
+        shard.map.store(key, std::move(val));
+    }
+
+    bool erase(const TKey& key)
+    {
+        Shard& shard = shardOf(key);
+        std::lock_guard lk(shard.mutex);
+        return shard.map.erase(key);
+    }
+
+    // Shards are counted one after another, so the result is exact only without concurrent writers.
+    std::size_t size() const
+    {
+        std::size_t out = 0;
+        for (const auto& shard : shards_)
+        {
+            std::shared_lock lk(shard.mutex);
+            out += shard.map.size();
+        }
+        return out;
+    }
+
+    std::size_t shardIndex(const TKey& key) const
+    {
+        return mix64(hashFunction_(key)) >> (64 - TShardWidth);
+    }
+
+private:
+    Shard& shardOf(const TKey& key)
+    {
+        return shards_[shardIndex(key)];
+    }
+
+    const Shard& shardOf(const TKey& key) const
+    {
+        return shards_[shardIndex(key)];
+    }
+
+    /* mutable: shardIndex() is const, Hash::operator() need not be. */
+    mutable Hash hashFunction_;
+    std::array<Shard, Shards> shards_;
+};
+
+}  // namespace non_std::containers::thread_safe
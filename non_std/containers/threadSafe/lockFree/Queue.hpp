@@ -4,18 +4,22 @@
 #include <atomic>
 #include <memory>
 #include <utility>
+#include <stdint.h>
+
+#include <non_std/ConcurrentPoolAllocator.hpp>
 
 namespace non_std::containers::thread_safe::lock_free
 {
 
-template <typename T>
+template <typename T, template <typename> class TNodeAllocator = ConcurrentPoolAllocator>
 class Queue
 {
 	struct InternalNode;
 	struct Node
 	{
 		InternalNode* internalNode_ = nullptr;
-		int externalCount_;
+		// Pointer sized, so Node has no padding bytes which would make compare_exchange spin forever.
+		intptr_t externalCount_;
 	};
 
 	struct NodeCounter
@@ -40,29 +44,13 @@ class Queue
 			next_.externalCount_ = 2;
 			next_.internalNode_ = nullptr;
 		}
-
-		void releaseRef()
-		{
-			NodeCounter oldCounter = count_.load();
-			NodeCounter newCounter;
-			do
-			{
-				newCounter = oldCounter;
-				--newCounter.internalCount;
-			} while (!count_.compare_exchange_strong(oldCounter, newCounter));
-
-			if (newCounter.internalCount == 0 && newCounter.externalCount == 0)
-			{
-				delete this;
-			}
-		}
 	};
 public:
 	Queue()
 	{
 		Node head;
 		head.externalCount_ = 1;
-		head.internalNode_ = new InternalNode();
+		head.internalNode_ = createNode();
 		head_.store(head);
 		tail_.store(head);
 	}
@@ -70,14 +58,14 @@ public:
 	~Queue()
 	{
 		while (pop()); // not really effincient, but working ;)
-		delete tail_.load().internalNode_;
+		destroyNode(tail_.load().internalNode_);
 	}
 
 	void push(T data)
 	{
 		std::unique_ptr<T> newData(new T(data));
 		Node newNext;
-		newNext.internalNode_ = new InternalNode;
+		newNext.internalNode_ = createNode();
 		newNext.externalCount_ = 1;
 
 		Node oldTail = tail_.load();
@@ -94,7 +82,7 @@ public:
 				newData.release();
 				break;
 			}
-			oldTail.internalNode_->releaseRef();
+			releaseRef(oldTail.internalNode_);
 		}
 	}
 
@@ -108,19 +96,47 @@ public:
 			InternalNode* ptr = oldHead.internalNode_;
 			if (ptr == tail_.load().internalNode_)
 			{
-				ptr->releaseRef();
+				releaseRef(ptr);
 				return std::unique_ptr<T>();
 			}
 			if (head_.compare_exchange_strong(oldHead, ptr->next_))
 			{
-				T* const res = ptr->data_.exchange(nullptr);
+				// data_ is left set: a pusher still holding this node as its stale tail must fail its CAS.
+				T* const res = ptr->data_.load();
 				freeExternalCounter(oldHead);
 				return std::unique_ptr<T>(res);
 			}
-			ptr->releaseRef();
+			releaseRef(ptr);
 		}
 	}
 private:
+	InternalNode* createNode()
+	{
+		return std::construct_at(allocator_.allocate());
+	}
+
+	void destroyNode(InternalNode* node)
+	{
+		std::destroy_at(node);
+		allocator_.dealocate(node);
+	}
+
+	void releaseRef(InternalNode* node)
+	{
+		NodeCounter oldCounter = node->count_.load();
+		NodeCounter newCounter;
+		do
+		{
+			newCounter = oldCounter;
+			--newCounter.internalCount;
+		} while (!node->count_.compare_exchange_strong(oldCounter, newCounter));
+
+		if (newCounter.internalCount == 0 && newCounter.externalCount == 0)
+		{
+			destroyNode(node);
+		}
+	}
+
 	void increaseExternalCount(std::atomic<Node>& counter,
 		Node& oldCounter)
 	{
@@ -137,7 +153,7 @@ private:
 	void freeExternalCounter(Node& oldNode)
 	{
 		InternalNode* ptr = oldNode.internalNode_;
-		int const count_increase = oldNode.externalCount_ - 2;
+		int const count_increase = static_cast<int>(oldNode.externalCount_ - 2);
 		NodeCounter oldCounter = ptr->count_.load();
 		NodeCounter newCounter;
 		do
@@ -149,10 +165,11 @@ private:
 
 		if (!newCounter.internalCount && !newCounter.externalCount)
 		{
-			delete ptr;
+			destroyNode(ptr);
 		}
 	}
 private:
+	TNodeAllocator<InternalNode> allocator_;
 	std::atomic<Node> head_;
 	std::atomic<Node> tail_;
 };
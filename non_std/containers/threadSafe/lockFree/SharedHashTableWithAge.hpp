@@ -0,0 +1,198 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <stdint.h>
+
+#include <non_std/containers/Hash.hpp>
+#include <non_std/containers/Traits.hpp>
+
+namespace non_std::containers::thread_safe::lock_free
+{
+
+/*
+Concurrent counterpart of FixedSizeHashTableOpenHashingWithAge for tables shared by parallel searches
+(transposition table style). No locks: get() and store() only load and store relaxed 64-bit atomics.
+1. A key is identified by its 64-bit hash (exact for integral keys with std::hash). A slot holds the
+   value and a generation tag in Words data words, plus a check word:
+   hash ^ mix(data[0], 0) ^ ... ^ mix(data[n], n), where mix() runs a word, salted by its index,
+   through mix64. A reader recomputes the hash from the words it loaded, so a slot torn by
+   concurrent writers matches no key and is treated as a miss.
+2. get() writes nothing. store() replaces the key's own slot, else a free one, else the one of the
+   oldest generation among HashTries probes. The caller advances the generation (newGeneration()),
+   e.g. once per search. The generation tag has 15 bits and wraps silently: age is counted modulo
+   2^15, so an entry untouched for 32768 generations looks as fresh as a new one.
+3. Racing stores to one slot may lose both entries (the slot fails the check). A reader which loads
+   the check of one store and data words of others gets a mix only on a 64-bit collision of the
+   mixed words (about 2^-64 per torn read, like the key identity). mix() is not linear, so no
+   choice of values makes that systematic, as it would be with a plain XOR of the words.
+4. TValue must be trivially copyable. clear() must not run concurrently with other calls.
+*/
+template<typename TKey,
+		typename TValue,
+		typename Hash = std::hash<TKey>>
+class SharedHashTableWithAge
+{
+	static_assert(std::is_trivially_copyable_v<TValue>);
+
+	// Value bytes, then a 16-bit tag: valid bit and 15-bit generation.
+	static constexpr std::size_t Words = (sizeof(TValue) + sizeof(uint16_t) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+	static constexpr uint16_t Valid = 0x8000;
+	static constexpr uint16_t GenerationMask = 0x7fff;
+
+	struct Slot
+	{
+		std::atomic<uint64_t> check;
+		std::atomic<uint64_t> data[Words];
+	};
+
+	struct Loaded
+	{
+		uint64_t check;
+		uint64_t hash;
+		uint64_t data[Words];
+	};
+
+public:
+	constexpr static OverwriteOlderElements_Taq OverwriteCategory {};
+	constexpr static unsigned int HashTries = 5;
+
+	explicit SharedHashTableWithAge(std::size_t entries)
+		: capacity_(std::bit_ceil(std::max<std::size_t>(entries, HashTries)))
+		, slots_(std::make_unique<Slot[]>(capacity_))
+	{
+	}
+
+	SharedHashTableWithAge(const SharedHashTableWithAge&) = delete;
+	SharedHashTableWithAge& operator=(const SharedHashTableWithAge&) = delete;
+
+	std::size_t capacity() const noexcept
+	{
+		return capacity_;
+	}
+
+	std::optional<TValue> get(const TKey& key) const noexcept
+	{
+		const uint64_t hash = hashFunction_(key);
+		for (std::size_t i = 0; i < HashTries; ++i)
+		{
+			const Loaded loaded = load(slots_[(hash + i) & (capacity_ - 1)]);
+			const uint16_t tag = tagOf(loaded);
+			if ((tag & Valid) == 0)
+			{
+				// Free, or torn in a way which hides the valid bit: either way the key is not here.
+				if (loaded.check == 0)
+				{
+					return std::nullopt;
+				}
+				continue;
+			}
+			if (loaded.hash == hash)
+			{
+				TValue out;
+				std::memcpy(&out, loaded.data, sizeof(TValue));
+				return out;
+			}
+		}
+		return std::nullopt;
+	}
+
+	void store(const TKey& key, const TValue& value) noexcept
+	{
+		const uint64_t hash = hashFunction_(key);
+		const uint16_t generation = generation_.load(std::memory_order_relaxed) & GenerationMask;
+		Slot* victim = nullptr;
+		int victimAge = -1;
+		for (std::size_t i = 0; i < HashTries; ++i)
+		{
+			Slot& slot = slots_[(hash + i) & (capacity_ - 1)];
+			const Loaded loaded = load(slot);
+			const uint16_t tag = tagOf(loaded);
+			if ((tag & Valid) != 0 && loaded.hash == hash)
+			{
+				victim = &slot;
+				break;
+			}
+			// Free and torn slots first, then the oldest generation.
+			const int age = (tag & Valid) == 0 ? GenerationMask + 1 : (generation - tag) & GenerationMask;
+			if (age > victimAge)
+			{
+				victimAge = age;
+				victim = &slot;
+			}
+		}
+
+		unsigned char bytes[Words * sizeof(uint64_t)] = {};
+		std::memcpy(bytes, &value, sizeof(TValue));
+		const uint16_t tag = Valid | generation;
+		std::memcpy(bytes + sizeof(bytes) - sizeof(uint16_t), &tag, sizeof(uint16_t));
+		uint64_t check = hash;
+		for (std::size_t w = 0; w < Words; ++w)
+		{
+			uint64_t word;
+			std::memcpy(&word, bytes + w * sizeof(uint64_t), sizeof(uint64_t));
+			check ^= mix(word, w);
+			victim->data[w].store(word, std::memory_order_relaxed);
+		}
+		victim->check.store(check, std::memory_order_relaxed);
+	}
+
+	/* Entries stored from now on are younger than all earlier ones. */
+	void newGeneration() noexcept
+	{
+		generation_.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	void clear() noexcept
+	{
+		for (std::size_t i = 0; i < capacity_; ++i)
+		{
+			slots_[i].check.store(0, std::memory_order_relaxed);
+			for (auto& word : slots_[i].data)
+			{
+				word.store(0, std::memory_order_relaxed);
+			}
+		}
+	}
+
+private:
+	static Loaded load(const Slot& slot) noexcept
+	{
+		Loaded out;
+		out.check = slot.check.load(std::memory_order_relaxed);
+		out.hash = out.check;
+		for (std::size_t w = 0; w < Words; ++w)
+		{
+			out.data[w] = slot.data[w].load(std::memory_order_relaxed);
+			out.hash ^= mix(out.data[w], w);
+		}
+		return out;
+	}
+
+	static uint64_t mix(uint64_t word, std::size_t index) noexcept
+	{
+		return mix64(word ^ ((index + 1) * 0x9e3779b97f4a7c15ull));
+	}
+
+	static uint16_t tagOf(const Loaded& loaded) noexcept
+	{
+		uint16_t tag;
+		std::memcpy(&tag, reinterpret_cast<const unsigned char*>(loaded.data) + sizeof(loaded.data) - sizeof(uint16_t),
+			sizeof(uint16_t));
+		return tag;
+	}
+
+	std::decay_t<decltype(Hash())> hashFunction_;
+	std::size_t capacity_;
+	std::unique_ptr<Slot[]> slots_;
+	std::atomic<uint64_t> generation_ = 0;
+};
+
+}  // namespace non_std::containers::thread_safe::lock_free
@@ -4,10 +4,13 @@
 #include <atomic>
 #include <memory>
 #include <utility>
+#include <stdint.h>
+
+#include <non_std/ConcurrentPoolAllocator.hpp>
 
 namespace non_std::containers::thread_safe::lock_free
 {
-template <typename T>
+template <typename T, template <typename> class TNodeAllocator = ConcurrentPoolAllocator>
 class Stack
 {
 
@@ -15,7 +18,8 @@ struct InternalNode;
 
 struct node_ptr
 {
-	int count = 0;
+	// Pointer sized, so node_ptr has no padding bytes which would make compare_exchange spin forever.
+	intptr_t count = 0;
 	InternalNode* internalPtr = nullptr;
 };
 
@@ -35,7 +39,7 @@ public:
 	void push(const T& data)
 	{
 		node_ptr toPush{};
-		toPush.internalPtr = new InternalNode(data);
+		toPush.internalPtr = std::construct_at(allocator_.allocate(), data);
 		toPush.count = 1;
 		toPush.internalPtr->next = head_.load(std::memory_order_relaxed);
 
@@ -59,19 +63,25 @@ public:
 				std::shared_ptr<T> res;
 				res.swap(internalNode->data_);
 
-				auto toAdd = oldHead.count - 2;
+				auto toAdd = static_cast<int>(oldHead.count - 2);
 				if (internalNode->count.fetch_add(toAdd, std::memory_order_release) == -toAdd)
 				{
-					delete internalNode;
+					destroyNode(internalNode);
 				}
 				return res;
 			} else if (internalNode->count.fetch_sub(1, std::memory_order_relaxed) == 1)
 			{
-				delete internalNode;
+				destroyNode(internalNode);
 			}
 		}
 	}
 private:
+	void destroyNode(InternalNode* node)
+	{
+		std::destroy_at(node);
+		allocator_.dealocate(node);
+	}
+
 	void increaseHeadCounter(node_ptr& oldHead)
 	{
 		node_ptr newHead;
@@ -84,6 +94,7 @@ private:
 		oldHead.count = newHead.count;
 	}
 
+	TNodeAllocator<InternalNode> allocator_;
 	std::atomic<node_ptr> head_;
 };
 
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <stdint.h>
+
+// MSVC does not define __SSE2__: x64 always has SSE2, x86 has it with /arch:SSE2 or above.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define NON_STD_CONTROL_GROUP_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace non_std::internal
+{
+
+/*
+Sixteen one-byte slot tags of an open addressing table, compared at once.
+Tag byte values: Empty (0, so zero filled memory is an empty table) or Full | 7 bits of the hash.
+match*() return a bitmask with bit i set when byte i matches.
+*/
+class ControlGroup
+{
+public:
+    static constexpr std::size_t Width = 16;
+    static constexpr uint8_t Empty = 0x00;
+    static constexpr uint8_t Full = 0x80;
+
+    static constexpr uint8_t tag(uint64_t hash) noexcept
+    {
+        return Full | static_cast<uint8_t>(hash & 0x7f);
+    }
+
+    explicit ControlGroup(const uint8_t* bytes) noexcept
+#ifdef NON_STD_CONTROL_GROUP_SSE2
+        : bytes_(_mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes)))
+#else
+        : bytes_(bytes)
+#endif // NON_STD_CONTROL_GROUP_SSE2
+    {
+    }
+
+    uint32_t match(uint8_t byte) const noexcept
+    {
+#ifdef NON_STD_CONTROL_GROUP_SSE2
+        return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes_, _mm_set1_epi8(static_cast<char>(byte)))));
+#else
+        uint32_t out = 0;
+        for (std::size_t i = 0; i < Width; ++i)
+        {
+            out |= uint32_t(bytes_[i] == byte) << i;
+        }
+        return out;
+#endif // NON_STD_CONTROL_GROUP_SSE2
+    }
+
+    uint32_t matchEmpty() const noexcept
+    {
+        return match(Empty);
+    }
+
+private:
+#ifdef NON_STD_CONTROL_GROUP_SSE2
+    __m128i bytes_;
+#else
+    const uint8_t* bytes_;
+#endif // NON_STD_CONTROL_GROUP_SSE2
+};
+
+}  // namespace non_std::internal
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <cstddef>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif // __linux__
+
+namespace non_std::internal
+{
+
+/*
+Whole file mapped read only. Pages are read in by the kernel on first touch, nothing is parsed.
+1. copyOnWrite maps it private and writable: writes go to private copies of the touched pages, the file
+   does not change.
+2. populate (MAP_POPULATE) reads the whole file in while mapping, so later accesses do not fault.
+Falls back to reading the file into a max_align_t aligned buffer where mmap is not available.
+*/
+class MappedFile
+{
+public:
+    MappedFile() noexcept = default;
+
+    explicit MappedFile(const std::string& path, bool copyOnWrite = false, bool populate = false)
+    {
+#ifdef __linux__
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        struct stat info;
+        if (fd < 0 || ::fstat(fd, &info) != 0)
+        {
+            if (fd >= 0)
+            {
+                ::close(fd);
+            }
+            throw std::runtime_error("MappedFile: cannot open " + path);
+        }
+        size_ = static_cast<std::size_t>(info.st_size);
+        if (size_ > 0)
+        {
+            const int protection = copyOnWrite ? PROT_READ | PROT_WRITE : PROT_READ;
+            void* mapped = ::mmap(nullptr, size_, protection, MAP_PRIVATE | (populate ? MAP_POPULATE : 0), fd, 0);
+            if (mapped == MAP_FAILED)
+            {
+                ::close(fd);
+                throw std::runtime_error("MappedFile: cannot map " + path);
+            }
+            data_ = static_cast<const unsigned char*>(mapped);
+        }
+        ::close(fd);
+#else
+        (void)copyOnWrite;
+        (void)populate;
+        std::ifstream in(path, std::ios::binary | std::ios::ate);
+        if (!in)
+        {
+            throw std::runtime_error("MappedFile: cannot open " + path);
+        }
+        size_ = static_cast<std::size_t>(in.tellg());
+        buffer_ = std::make_unique<std::max_align_t[]>((size_ + sizeof(std::max_align_t) - 1) / sizeof(std::max_align_t));
+        in.seekg(0);
+        in.read(reinterpret_cast<char*>(buffer_.get()), size_);
+        data_ = reinterpret_cast<const unsigned char*>(buffer_.get());
+#endif // __linux__
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    MappedFile(MappedFile&& other) noexcept
+    {
+        swap(other);
+    }
+
+    MappedFile& operator=(MappedFile&& other) noexcept
+    {
+        if (this != &other)
+        {
+            MappedFile(std::move(other)).swap(*this);
+        }
+        return *this;
+    }
+
+    ~MappedFile()
+    {
+#ifdef __linux__
+        if (data_ != nullptr)
+        {
+            ::munmap(const_cast<unsigned char*>(data_), size_);
+        }
+#endif // __linux__
+    }
+
+    void swap(MappedFile& other) noexcept
+    {
+        std::swap(data_, other.data_);
+        std::swap(size_, other.size_);
+#ifndef __linux__
+        std::swap(buffer_, other.buffer_);
+#endif // __linux__
+    }
+
+    const unsigned char* data() const noexcept { return data_; }
+    // Only for a copyOnWrite mapping.
+    unsigned char* mutableData() noexcept { return const_cast<unsigned char*>(data_); }
+    std::size_t size() const noexcept { return size_; }
+
+private:
+    const unsigned char* data_ = nullptr;
+    std::size_t size_ = 0;
+#ifndef __linux__
+    std::unique_ptr<std::max_align_t[]> buffer_;
+#endif // __linux__
+};
+
+// Writes size bytes from data to path, replacing the file.
+inline void writeFile(const std::string& path, const void* data, std::size_t size)
+{
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+    if (!out)
+    {
+        throw std::runtime_error("writeFile: cannot write " + path);
+    }
+}
+
+}  // namespace non_std::internal
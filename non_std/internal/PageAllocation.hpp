@@ -0,0 +1,212 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <stdint.h>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/mempolicy.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif // __linux__
+
+namespace non_std::internal
+{
+
+constexpr std::size_t PageSize = 4096;
+constexpr std::size_t HugePageSize = 2u << 20;
+
+/*
+How the pages of a large block are backed. Every option is a hint: when the system refuses it, the
+block gets ordinary pages.
+1. hugePages: the block is HugePageSize aligned and advised as MADV_HUGEPAGE, so transparent huge
+   pages back it when the kernel allows.
+2. interleave: pages go round robin to the NUMA nodes the process may use (MPOL_INTERLEAVE).
+3. touchThreads > 1: containers which initialize the block write it from that many threads, each its
+   own contiguous part (firstTouch()), so with the default first touch placement every part lands
+   on the node of the thread which wrote it. Threads are not pinned: the scheduler spreads them.
+4. mapPages = false: the block comes from aligned operator new and is zero filled up front, as on
+   platforms without mmap. Huge pages and interleaving do not apply then.
+Whichever way the block is backed, it reads as zero when handed out.
+*/
+struct PagePolicy
+{
+    bool hugePages = false;
+    bool interleave = false;
+    unsigned touchThreads = 1;
+    bool mapPages = true;
+};
+
+namespace detail
+{
+
+inline std::size_t pageAlignment(const PagePolicy& policy, std::size_t alignment) noexcept
+{
+    return std::max({alignment, policy.hugePages ? HugePageSize : PageSize, PageSize});
+}
+
+/* Callers of allocatePages() take the block as zero filled, as mapped pages are. */
+inline void* allocateUnmapped(std::size_t bytes, std::size_t alignment, bool zeroFill)
+{
+    void* out = ::operator new(bytes, std::align_val_t(alignment));
+    if (zeroFill)
+    {
+        std::memset(out, 0, bytes);
+    }
+    return out;
+}
+
+#ifdef __linux__
+inline void* mapAligned(std::size_t bytes, std::size_t alignment) noexcept
+{
+    if (alignment == PageSize)
+    {
+        void* mapped = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        return mapped == MAP_FAILED ? nullptr : mapped;
+    }
+    // Over-map by the alignment and cut the unaligned head and tail off.
+    auto mappedBytes = bytes + alignment;
+    void* mapped = mmap(nullptr, mappedBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapped == MAP_FAILED)
+    {
+        return nullptr;
+    }
+    auto begin = reinterpret_cast<uintptr_t>(mapped);
+    auto aligned = (begin + alignment - 1) & ~uintptr_t(alignment - 1);
+    auto end = begin + mappedBytes;
+    auto alignedEnd = aligned + (bytes + PageSize - 1) / PageSize * PageSize;
+    if (aligned != begin)
+    {
+        munmap(mapped, aligned - begin);
+    }
+    if (alignedEnd != end)
+    {
+        munmap(reinterpret_cast<void*>(alignedEnd), end - alignedEnd);
+    }
+    return reinterpret_cast<void*>(aligned);
+}
+
+inline void interleave(void* in, std::size_t bytes) noexcept
+{
+    unsigned long nodes[16] = {};
+    constexpr unsigned long maxNode = sizeof(nodes) * 8;
+    if (syscall(SYS_get_mempolicy, nullptr, nodes, maxNode, nullptr, MPOL_F_MEMS_ALLOWED) != 0)
+    {
+        return;
+    }
+    syscall(SYS_mbind, in, (bytes + PageSize - 1) / PageSize * PageSize, MPOL_INTERLEAVE, nodes, maxNode, 0);
+}
+#endif // __linux__
+
+}  // namespace detail
+
+/*
+Page aligned, zero filled memory straight from the system, placed as policy asks, aligned to at least
+alignment (a power of two). Falls back to zero filled aligned operator new where mmap is not
+available; zeroFill = false skips that fill for callers which initialize the block themselves.
+Blocks must be released with freePages() and the same bytes, policy and alignment.
+*/
+inline void* allocatePages(std::size_t bytes, const PagePolicy& policy, std::size_t alignment = PageSize,
+                           bool zeroFill = true)
+{
+    const auto aligned = detail::pageAlignment(policy, alignment);
+#ifdef __linux__
+    if (!policy.mapPages)
+    {
+        return detail::allocateUnmapped(bytes, aligned, zeroFill);
+    }
+    void* mapped = detail::mapAligned(bytes, aligned);
+    if (mapped == nullptr && aligned != PageSize && alignment <= PageSize)
+    {
+        // Only huge pages asked for the extra alignment: ordinary pages are still fine (and zero too).
+        mapped = detail::mapAligned(bytes, PageSize);
+    }
+    if (mapped == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    if (policy.hugePages)
+    {
+        madvise(mapped, (bytes + PageSize - 1) / PageSize * PageSize, MADV_HUGEPAGE);
+    }
+    if (policy.interleave)
+    {
+        detail::interleave(mapped, bytes);
+    }
+    return mapped;
+#else
+    return detail::allocateUnmapped(bytes, aligned, zeroFill);
+#endif // __linux__
+}
+
+inline void freePages(void* in, std::size_t bytes, const PagePolicy& policy, std::size_t alignment = PageSize)
+{
+#ifdef __linux__
+    if (policy.mapPages)
+    {
+        munmap(in, (bytes + PageSize - 1) / PageSize * PageSize);
+        return;
+    }
+#endif // __linux__
+    (void)bytes;
+    ::operator delete(in, std::align_val_t(detail::pageAlignment(policy, alignment)));
+}
+
+/* Gives the pages of [in, in + bytes) back to the system while keeping the range allocated: they */
+/* read as zero when touched again. in and bytes must be page aligned, inside a block allocatePages() */
+/* gave for policy. Does nothing for blocks which are not mapped. */
+inline void discardPages(void* in, std::size_t bytes, const PagePolicy& policy) noexcept
+{
+#ifdef __linux__
+    if (policy.mapPages)
+    {
+        madvise(in, bytes, MADV_DONTNEED);
+    }
+#else
+    (void)policy;
+    (void)in;
+    (void)bytes;
+#endif // __linux__
+}
+
+inline void* allocatePages(std::size_t bytes, bool hugePages)
+{
+    return allocatePages(bytes, PagePolicy{hugePages});
+}
+
+inline void freePages(void* in, std::size_t bytes, bool hugePages)
+{
+    freePages(in, bytes, PagePolicy{hugePages});
+}
+
+/* Calls init(begin, end) for threads contiguous parts of [0, count), each on a thread of its own. */
+/* init must not throw. */
+template <typename F>
+void firstTouch(std::size_t count, unsigned threads, const F& init)
+{
+    threads = static_cast<unsigned>(std::min<std::size_t>(std::max(threads, 1u), std::max<std::size_t>(count, 1)));
+    if (threads == 1)
+    {
+        init(std::size_t(0), count);
+        return;
+    }
+    std::vector<std::thread> workers;
+    workers.reserve(threads);
+    for (unsigned t = 0; t < threads; ++t)
+    {
+        workers.emplace_back([&init, begin = count * t / threads, end = count * (t + 1) / threads]() {
+            init(begin, end);
+        });
+    }
+    for (auto& worker : workers)
+    {
+        worker.join();
+    }
+}
+
+}  // namespace non_std::internal
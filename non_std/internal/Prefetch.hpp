@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <stdint.h>
+
+#ifdef _MSC_VER
+    #include <xmmintrin.h>
+#endif // _MSC_VER
+
+namespace non_std::internal
+{
+
+// Hints the cache line holding in into all cache levels; never faults, so any address is fine.
+inline void prefetch(const void* in) noexcept
+{
+#ifdef __GNUC__
+    __builtin_prefetch(in, 0, 3);
+#endif // __GNUC__
+#ifdef _MSC_VER
+    _mm_prefetch(static_cast<const char*>(in), _MM_HINT_T0);
+#endif // _MSC_VER
+}
+
+// Hints every cache line of [in, in + bytes).
+inline void prefetch(const void* in, std::size_t bytes) noexcept
+{
+    constexpr uintptr_t CacheLine = 64;
+    const auto begin = reinterpret_cast<uintptr_t>(in) & ~(CacheLine - 1);
+    const auto end = reinterpret_cast<uintptr_t>(in) + bytes;
+    for (auto line = begin; line < end; line += CacheLine)
+    {
+        prefetch(reinterpret_cast<const void*>(line));
+    }
+}
+
+}  // namespace non_std::internal
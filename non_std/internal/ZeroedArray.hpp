@@ -0,0 +1,121 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include <non_std/internal/PageAllocation.hpp>
+
+namespace non_std::internal
+{
+
+/*
+Fixed size, zero filled array of trivial T (e.g. hash table buckets).
+Arrays of at least MappedThreshold bytes are mapped straight from the system, which hands out
+zero pages lazily: creating one does not write it, page faults are paid as elements are touched.
+Mapped arrays are placed as PagePolicy asks; with touchThreads > 1 their pages are touched up front,
+by that many threads.
+*/
+template <typename T>
+class ZeroedArray
+{
+    static_assert(std::is_trivially_copyable_v<T> && std::is_trivially_destructible_v<T>);
+public:
+    static constexpr std::size_t MappedThreshold = 256 * 1024;
+
+    ZeroedArray() noexcept = default;
+
+    explicit ZeroedArray(std::size_t size, const PagePolicy& policy = {})
+        : size_(size)
+        , policy_(policy)
+    {
+        if (bytes() >= MappedThreshold)
+        {
+            data_ = static_cast<T*>(allocatePages(bytes(), policy_));
+            if (policy_.touchThreads > 1)
+            {
+                auto* pages = reinterpret_cast<volatile unsigned char*>(data_);
+                firstTouch(bytes() / PageSize, policy_.touchThreads, [pages](std::size_t begin, std::size_t end) {
+                    for (std::size_t page = begin; page < end; ++page)
+                    {
+                        pages[page * PageSize] = 0;
+                    }
+                });
+            }
+        }
+        else if (size_ > 0)
+        {
+            data_ = static_cast<T*>(std::calloc(size_, sizeof(T)));
+            if (data_ == nullptr)
+            {
+                throw std::bad_alloc();
+            }
+        }
+    }
+
+    ZeroedArray(const ZeroedArray&) = delete;
+    ZeroedArray& operator=(const ZeroedArray&) = delete;
+
+    ZeroedArray(ZeroedArray&& other) noexcept
+        : data_(std::exchange(other.data_, nullptr))
+        , size_(std::exchange(other.size_, 0))
+        , policy_(other.policy_)
+    {
+    }
+
+    ZeroedArray& operator=(ZeroedArray&& other) noexcept
+    {
+        if (this != &other)
+        {
+            release();
+            data_ = std::exchange(other.data_, nullptr);
+            size_ = std::exchange(other.size_, 0);
+            policy_ = other.policy_;
+        }
+        return *this;
+    }
+
+    ~ZeroedArray()
+    {
+        release();
+    }
+
+    T& operator[](std::size_t index) noexcept { return data_[index]; }
+    const T& operator[](std::size_t index) const noexcept { return data_[index]; }
+    T* begin() noexcept { return data_; }
+    T* end() noexcept { return data_ + size_; }
+    std::size_t size() const noexcept { return size_; }
+    bool empty() const noexcept { return size_ == 0; }
+
+private:
+    std::size_t bytes() const noexcept
+    {
+        return size_ * sizeof(T);
+    }
+
+    void release() noexcept
+    {
+        if (data_ == nullptr)
+        {
+            return;
+        }
+        if (bytes() >= MappedThreshold)
+        {
+            freePages(data_, bytes(), policy_);
+        }
+        else
+        {
+            std::free(data_);
+        }
+        data_ = nullptr;
+        size_ = 0;
+    }
+
+    T* data_ = nullptr;
+    std::size_t size_ = 0;
+    PagePolicy policy_;
+};
+
+}  // namespace non_std::internal
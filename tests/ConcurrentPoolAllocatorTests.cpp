@@ -0,0 +1,159 @@
+#include "ConcurrentPoolAllocatorTests.hpp"
+
+#include <non_std/ConcurrentPoolAllocator.hpp>
+#include <non_std/containers/threadSafe/lockFree/Queue.hpp>
+#include <non_std/containers/threadSafe/lockFree/Stack.hpp>
+
+#include <atomic>
+#include <cassert>
+#include <iostream>
+#include <set>
+#include <stdint.h>
+#include <thread>
+#include <vector>
+
+namespace test::concurrent_pool_allocator
+{
+
+constexpr int Threads = 4;
+
+void testNodesAreUniqueAcrossThreads()
+{
+    constexpr int PerThread = 5000;
+    std::vector<std::vector<uint64_t*>> allocated(Threads);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < Threads; ++t)
+    {
+        threads.emplace_back([t, &allocated]() {
+            ConcurrentPoolAllocator<uint64_t> allocator;
+            for (int i = 0; i < PerThread; ++i)
+            {
+                allocated[t].push_back(allocator.allocate());
+                *allocated[t].back() = t;
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    std::set<uint64_t*> seen;
+    ConcurrentPoolAllocator<uint64_t> allocator;
+    for (int t = 0; t < Threads; ++t)
+    {
+        for (auto* ptr : allocated[t])
+        {
+            assert(*ptr == uint64_t(t) && "node shall not be shared between threads");
+            assert(seen.insert(ptr).second && "allocator shall never hand out the same node twice");
+            allocator.dealocate(ptr);
+        }
+    }
+}
+
+void testCrossThreadFreesReturnToOwner()
+{
+    ConcurrentPoolAllocator<uint64_t> allocator;
+    std::vector<uint64_t*> nodes;
+    for (unsigned i = 0; i < ConcurrentPoolAllocator<uint64_t>::BatchSize; ++i)
+    {
+        nodes.push_back(allocator.allocate());
+    }
+    std::thread([&nodes]() {
+        ConcurrentPoolAllocator<uint64_t> remote;
+        for (auto* ptr : nodes)
+        {
+            remote.dealocate(ptr);
+        }
+    }).join();
+
+    // Drain the local magazine (it may hold a parked cache adopted from an exited thread);
+    // the remotely freed batch shall be reused once it is empty.
+    std::set<uint64_t*> freed(nodes.begin(), nodes.end());
+    std::set<uint64_t*> reused;
+    for (int i = 0; i < 1000000 && reused.size() < freed.size(); ++i)
+    {
+        auto* ptr = allocator.allocate();
+        if (freed.count(ptr))
+        {
+            reused.insert(ptr);
+        }
+    }
+    assert(reused.size() == freed.size() && "nodes freed by other thread shall come back to the owner");
+}
+
+void testQueue()
+{
+    constexpr int PerProducer = 20000;
+    non_std::containers::thread_safe::lock_free::Queue<int> queue;
+    std::atomic<long long> popped = 0;
+    std::atomic<int> poppedCount = 0;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < Threads / 2; ++t)
+    {
+        threads.emplace_back([&queue]() {
+            for (int i = 1; i <= PerProducer; ++i)
+            {
+                queue.push(i);
+            }
+        });
+        threads.emplace_back([&]() {
+            while (poppedCount.load() < Threads / 2 * PerProducer)
+            {
+                if (auto val = queue.pop())
+                {
+                    popped += *val;
+                    ++poppedCount;
+                }
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    assert(popped == Threads / 2 * (long long)PerProducer * (PerProducer + 1) / 2 && "queue shall deliver every element once");
+    assert(!queue.pop() && "queue shall be empty");
+}
+
+void testStack()
+{
+    constexpr int PerThread = 20000;
+    non_std::containers::thread_safe::lock_free::Stack<int> stack;
+    std::atomic<long long> popped = 0;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < Threads; ++t)
+    {
+        threads.emplace_back([&]() {
+            for (int i = 1; i <= PerThread; ++i)
+            {
+                stack.push(i);
+                if (auto val = stack.pop())
+                {
+                    popped += *val;
+                }
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    while (auto val = stack.pop())
+    {
+        popped += *val;
+    }
+    assert(popped == Threads * (long long)PerThread * (PerThread + 1) / 2 && "stack shall deliver every element once");
+}
+
+void test()
+{
+    testNodesAreUniqueAcrossThreads();
+    testCrossThreadFreesReturnToOwner();
+    testQueue();
+    testStack();
+
+    std::cout << "concurrent_pool_allocator passed" << std::endl;
+}
+
+}  // test::concurrent_pool_allocator
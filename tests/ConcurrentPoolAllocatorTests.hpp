@@ -0,0 +1,8 @@
+#pragma once
+
+namespace test::concurrent_pool_allocator
+{
+
+void test();
+
+}  // test::concurrent_pool_allocator
@@ -3,8 +3,12 @@
 #include <non_std/containers/FixedSizeHashTableOpenHashingWithAge.hpp>
 
 #include <cassert>
+#include <cstdio>
+#include <filesystem>
 #include <iostream>
+#include <stdexcept>
 #include <stdint.h>
+#include <string>
 
 namespace test::fixed_size_hash_table_open_hashing_with_age
 {
@@ -58,6 +62,348 @@ void testOverrideOlderElements()
 
 }
 
+void testStoreAndEmplace()
+{
+    const uint64_t key = (1ull << 40) + 7;
+    hastTable.store(key, ValueType{1.f, 2.0, 3});
+    assert(hastTable.get(key)->field3 == 3 && "store shall insert");
+    hastTable.store(key, ValueType{1.f, 2.0, 4});
+    assert(hastTable.get(key)->field3 == 4 && "store shall overwrite");
+
+    auto [existing, inserted] = hastTable.tryEmplace(key, 5.f, 6.0, 7);
+    assert(!inserted && existing->field3 == 4 && "tryEmplace shall not touch existing key");
+    {
+        auto [fresh, insertedFresh] = hastTable.tryEmplace(key + 1, 5.f, 6.0, 7);
+        assert(insertedFresh && fresh->field2 == 6.0 && "tryEmplace shall construct from args");
+    }
+    assert(!hastTable.insertOrAssign(key + 1, ValueType{0.f, 0.0, 8}).second && hastTable.get(key + 1)->field3 == 8
+        && "insertOrAssign shall assign existing key");
+}
+
+void testStoreOverridesOldest()
+{
+    uint64_t basePart = 63;
+    for (unsigned int i = 0; i < decltype(hastTable)::HashTries; ++i)
+    {
+        basePart += (1ull << 60);
+        hastTable.store(basePart, ValueType{0.f, 0.0, int(i)});
+    }
+    hastTable.get(63 + (1ull << 60));
+    hastTable.store(basePart + (1ull << 60), ValueType{0.f, 0.0, 1001});
+    assert(hastTable.get(63 + (1ull << 60)) != nullptr && "recently read element shall stay");
+    assert(hastTable.get(63 + (2ull << 60)).operator ValueType *() == nullptr && "store shall override the oldest element");
+}
+
+void testSizeClearAndResize()
+{
+    using Table = non_std::containers::FixedSizeHashTableOpenHashingWithAge<uint64_t, ValueType, PassTrhoughtHash>;
+    Table table(1000);
+    assert(table.capacity() == 1024 && "size shall be rounded up to a power of two");
+    assert(Table::withMemoryBudget(1u << 20).capacity() <= (1u << 20) / sizeof(ValueType)
+        && "memory budget shall not be exceeded");
+
+    for (uint64_t key = 0; key < 512; ++key)
+    {
+        table.store(key, ValueType{0.f, 0.0, int(key)});
+    }
+    table.clear();
+    assert(table.capacity() == 1024 && table.get(5).operator ValueType *() == nullptr && "clear shall forget every key");
+    table.store(5, ValueType{0.f, 0.0, 50});
+    assert(table.get(5)->field3 == 50 && table.get(6).operator ValueType *() == nullptr && "cleared table shall be usable");
+
+    for (uint64_t key = 0; key < 512; ++key)
+    {
+        table.store(key, ValueType{0.f, 0.0, int(key)});
+    }
+    table.resize(4096);
+    assert(table.capacity() == 4096 && "resize shall change capacity");
+    for (uint64_t key = 0; key < 512; ++key)
+    {
+        assert(table.get(key)->field3 == int(key) && "resize shall keep entries");
+    }
+    table.resize(256);
+    assert(table.get(511)->field3 == 511 && table.get(0).operator ValueType *() == nullptr
+        && "shrinking shall keep the youngest entries");
+}
+
+void testBucketLayoutAndLockedEntries()
+{
+    using Table = non_std::containers::FixedSizeHashTableOpenHashingWithAge<uint64_t, ValueType, PassTrhoughtHash>;
+    static_assert(Table::HashTries == 4 && "metas and 8-byte keys of a bucket shall share one cache line");
+    Table table(64);
+    assert(table.memoryUsage() < 64 * (sizeof(uint64_t) + sizeof(ValueType) + 16) && "entries shall not carry padding");
+
+    table.store(3, ValueType{0.f, 0.0, 3});
+    {
+        auto pinned = table.get(3);
+        table.clear();
+        for (uint64_t i = 1; i <= Table::HashTries; ++i)
+        {
+            table.store(3 + i * 64, ValueType{0.f, 0.0, int(i)});
+        }
+        assert(pinned->field3 == 3 && "locked entry shall never be replaced");
+    }
+    assert(table.get(3)->field3 == 3 && "entry locked during clear shall survive");
+    assert(table.get(3 + 64).operator ValueType *() == nullptr && table.get(3 + Table::HashTries * 64)->field3 == int(Table::HashTries)
+        && "least recently used unlocked entry shall be replaced");
+}
+
+void testLockedEntrySurvivesClearUntouched()
+{
+    using Table = non_std::containers::FixedSizeHashTableOpenHashingWithAge<uint64_t, ValueType, PassTrhoughtHash>;
+    Table table(64);
+    table.store(3, ValueType{0.f, 0.0, 3});
+    table.store(3 + 64, ValueType{0.f, 0.0, 4});
+    {
+        // Nothing touches the bucket between clear() and unlocking.
+        auto pinned = table.get(3);
+        table.clear();
+    }
+    assert(table.probe(3) && table.probe(3)->field3 == 3 && "entry locked during clear shall survive unlocking");
+    assert(!table.probe(3 + 64) && "unlocked entries of its bucket shall be cleared");
+    table.clear();
+    assert(!table.probe(3) && "a later clear shall forget the survivor");
+}
+
+void testGenerationAging()
+{
+    using Table = non_std::containers::FixedSizeHashTableOpenHashingWithAge<uint64_t, ValueType, PassTrhoughtHash,
+        non_std::containers::AgeByGeneration>;
+    Table table(64);
+    for (uint64_t i = 0; i < Table::HashTries; ++i)
+    {
+        table.store(5 + i * 64, ValueType{0.f, 0.0, int(i)});
+    }
+    table.get(5);
+    table.store(5 + Table::HashTries * 64, ValueType{});
+    assert(table.get(5).operator ValueType *() == nullptr && "hits within one generation shall not protect an entry");
+
+    table.newGeneration();
+    table.get(5 + 2 * 64);
+    table.store(5 + 64 * 64, ValueType{});
+    // The last store of the old generation loses to the entry hit in the new one.
+    assert(table.get(5 + 2 * 64) != nullptr && table.get(5 + Table::HashTries * 64).operator ValueType *() == nullptr
+        && "entry of an older generation shall be replaced first");
+}
+
+struct Depth
+{
+    int operator()(const ValueType& value) const { return value.field3; }
+};
+
+template <typename TReplacement>
+using PolicyTable = non_std::containers::FixedSizeHashTableOpenHashingWithAge<uint64_t, ValueType, PassTrhoughtHash,
+    non_std::containers::AgeByRecency, TReplacement>;
+
+// Fills bucket 5 of a 16 bucket table with depths 3, 1, 4, 2 (slot 0 first) and stores one more key of depth.
+template <typename TTable>
+void fillThenStore(TTable& table, int depth)
+{
+    const int depths[] = {3, 1, 4, 2};
+    for (uint64_t i = 0; i < TTable::HashTries; ++i)
+    {
+        table.store(5 + i * 64, ValueType{0.f, 0.0, depths[i % 4]});
+    }
+    table.store(5 + 100 * 64, ValueType{0.f, 0.0, depth});
+}
+
+template <typename TTable>
+bool has(TTable& table, uint64_t i)
+{
+    return table.get(5 + i * 64).operator ValueType *() != nullptr;
+}
+
+void testReplacementPolicies()
+{
+    {
+        PolicyTable<non_std::containers::ReplaceAlways> table(64);
+        fillThenStore(table, 0);
+        const uint64_t victim = non_std::containers::mix64(5 + 100 * 64) % 4;
+        for (uint64_t i = 0; i < 4; ++i)
+        {
+            assert(has(table, i) == (i != victim) && "always replace shall take the slot the hash picks");
+        }
+        assert(has(table, 100) && "always replace shall store the new key");
+    }
+    {
+        PolicyTable<non_std::containers::ReplaceLowestPriority<Depth, 0>> table(64);
+        fillThenStore(table, 0);
+        assert(!has(table, 1) && has(table, 0) && has(table, 2) && has(table, 100) && "shallowest entry shall be replaced");
+    }
+    {
+        PolicyTable<non_std::containers::ReplaceTwoTier<Depth>> table(64);
+        fillThenStore(table, 2);
+        const uint64_t victim = 1 + non_std::containers::mix64(5 + 100 * 64) % 3;
+        assert(has(table, 0) && !has(table, victim) && has(table, 100) && "shallower value shall not replace the protected slot");
+        table.store(5 + 101 * 64, ValueType{0.f, 0.0, 7});
+        assert(!has(table, 0) && has(table, 101) && "deeper value shall replace the protected slot");
+    }
+}
+
+// With std::hash (the identity for integers) small keys of one bucket shall still spread over its slots.
+template <typename TReplacement>
+void testReplacementSpreadsSmallKeys(uint64_t firstReplaceable)
+{
+    non_std::containers::FixedSizeHashTableOpenHashingWithAge<uint64_t, ValueType, std::hash<uint64_t>,
+        non_std::containers::AgeByRecency, TReplacement> table(64);
+    // Slot 0 is deeper than every later store, so the two tier policy keeps it.
+    for (uint64_t i = 0; i < 4; ++i)
+    {
+        table.store(5 + i * 16, ValueType{0.f, 0.0, i == 0 ? 5 : 0});
+    }
+    for (uint64_t i = 4; i < 200; ++i)
+    {
+        table.store(5 + i * 16, ValueType{0.f, 0.0, 0});
+    }
+    for (uint64_t i = firstReplaceable; i < 4; ++i)
+    {
+        assert(!table.probe(5 + i * 16) && "every replaceable slot shall be picked for small keys");
+    }
+}
+
+void testKeySignatures()
+{
+    using Table = non_std::containers::FixedSizeHashTableOpenHashingWithAge<uint64_t, ValueType, PassTrhoughtHash,
+        non_std::containers::AgeByRecency, non_std::containers::ReplaceOldest,
+        non_std::containers::KeySignatures<uint16_t>>;
+    static_assert(Table::HashTries == 8 && "16-bit signatures shall fit twice as many slots in a line");
+    Table table(1u << 12);
+    for (uint64_t i = 0; i < 8; ++i)
+    {
+        table.store(5 + (i << 48), ValueType{0.f, 0.0, int(i)});
+    }
+    for (uint64_t i = 0; i < 8; ++i)
+    {
+        assert(table.get(5 + (i << 48))->field3 == int(i) && "keys with different signatures shall be told apart");
+    }
+    assert(table.get(5 + (8ull << 48)).operator ValueType *() == nullptr && "missing signature shall not be found");
+
+    // Same bucket (512 buckets) and same signature: documented false positive.
+    const auto signature = [](uint64_t key) { return non_std::containers::mix64(key) >> 48; };
+    uint64_t twin = 5 + 512;
+    while (signature(twin) != signature(5))
+    {
+        twin += 512;
+    }
+    assert(table.get(twin) != nullptr && "keys of one bucket and signature shall collide");
+
+    // Sequential small keys with std::hash (the identity): missing ones shall not be found.
+    non_std::containers::FixedSizeHashTableOpenHashingWithAge<uint64_t, uint64_t, std::hash<uint64_t>,
+        non_std::containers::AgeByRecency, non_std::containers::ReplaceOldest,
+        non_std::containers::KeySignatures<uint32_t>> small(1u << 16);
+    for (uint64_t key = 0; key < (1u << 16); ++key)
+    {
+        small.store(key, key);
+    }
+    std::size_t wrong = 0;
+    for (uint64_t key = 1u << 16; key < (1u << 20); ++key)
+    {
+        wrong += small.probe(key).has_value();
+    }
+    assert(wrong == 0 && "missing small keys shall not match another key's signature");
+}
+
+void testProbeDoesNotWrite()
+{
+    using Table = non_std::containers::FixedSizeHashTableOpenHashingWithAge<uint64_t, ValueType, PassTrhoughtHash>;
+    Table table(64);
+    for (uint64_t i = 0; i < Table::HashTries; ++i)
+    {
+        table.store(5 + i * 64, ValueType{0.f, 0.0, int(i)});
+    }
+    const Table& constTable = table;
+    constTable.prefetch(5);
+    assert(constTable.probe(5)->field3 == 0 && !constTable.probe(6) && "probe shall find stored keys only");
+    table.store(5 + 100 * 64, ValueType{});
+    assert(!table.probe(5) && "probe shall not refresh the age of an entry");
+
+    {
+        auto pinned = table.get(5 + 64);
+        assert(table.probe(5 + 64)->field3 == 1 && "probe shall see locked entries");
+    }
+}
+
+void testSaveAndOpenMapped()
+{
+    using Table = non_std::containers::FixedSizeHashTableOpenHashingWithAge<uint64_t, ValueType, PassTrhoughtHash>;
+    const auto path = (std::filesystem::temp_directory_path() / "non_std_age_table_test.bin").string();
+    Table table(1024);
+    for (uint64_t key = 0; key < 1000; ++key)
+    {
+        table.store(key, ValueType{0.f, 0.0, int(key)});
+    }
+    table.clear();
+    table.store(7, ValueType{0.f, 0.0, 7});
+    {
+        auto pinned = table.get(7);
+        table.save(path);
+    }
+
+    for (bool populate : {false, true})
+    {
+        auto opened = Table::openMapped(path, populate);
+        assert(opened.capacity() == table.capacity() && "opened table shall keep the capacity");
+        assert(opened.get(7)->field3 == 7 && "opened table shall find saved entries");
+        assert(!opened.probe(8) && "opened table shall keep the clear epoch");
+        opened.store(9, ValueType{0.f, 0.0, 9});
+        auto copy = opened;
+        assert(copy.probe(9)->field3 == 9 && "copy of an opened table shall own its entries");
+
+        // A locked entry was saved as occupied, so it is replaced like any other one.
+        for (uint64_t i = 1; i <= Table::HashTries; ++i)
+        {
+            opened.store(7 + i * 1024, ValueType{});
+        }
+        assert(!opened.probe(7) && "saved locked entry shall be replaceable");
+    }
+    assert(!Table::openMapped(path).probe(9) && "stores into an opened table shall not change the file");
+
+    bool thrown = false;
+    try
+    {
+        non_std::containers::FixedSizeHashTableOpenHashingWithAge<uint64_t, uint64_t>::openMapped(path);
+    }
+    catch (const std::runtime_error&)
+    {
+        thrown = true;
+    }
+    assert(thrown && "openMapped shall reject a table of other types");
+    std::remove(path.c_str());
+}
+
+void testPagePolicy()
+{
+    using Table = non_std::containers::FixedSizeHashTableOpenHashingWithAge<uint64_t, ValueType, PassTrhoughtHash>;
+    Table table(1u << 16, non_std::internal::PagePolicy{true, true, 4});
+    for (uint64_t key = 0; key < table.capacity(); ++key)
+    {
+        assert(!table.probe(key) && "every part of the table shall start empty");
+        table.store(key, ValueType{0.f, 0.0, int(key)});
+    }
+    table.resize(1u << 17);
+    auto copy = table;
+    for (uint64_t key = 0; key < table.capacity() / 2; ++key)
+    {
+        assert(copy.probe(key)->field3 == int(key) && "table with a page policy shall keep every key");
+    }
+}
+
+void testUnmappedPages()
+{
+    using Table = non_std::containers::FixedSizeHashTableOpenHashingWithAge<uint64_t, ValueType, PassTrhoughtHash>;
+    Table table(1u << 16, non_std::internal::PagePolicy{false, false, 1, false});
+    for (uint64_t key = 0; key < table.capacity(); ++key)
+    {
+        assert(!table.probe(key) && "unmapped table shall start empty");
+        table.store(key, ValueType{0.f, 0.0, int(key)});
+    }
+    table.resize(1u << 17);
+    for (uint64_t key = 0; key < table.capacity() / 2; ++key)
+    {
+        assert(table.probe(key)->field3 == int(key) && "unmapped table shall keep every key");
+    }
+}
+
 void test()
 {
     for (uint64_t key = 1; key < 1000ull; ++key)
@@ -66,6 +412,20 @@ void test()
     }
 
     testOverrideOlderElements();
+    testStoreAndEmplace();
+    testStoreOverridesOldest();
+    testSizeClearAndResize();
+    testBucketLayoutAndLockedEntries();
+    testLockedEntrySurvivesClearUntouched();
+    testGenerationAging();
+    testReplacementPolicies();
+    testReplacementSpreadsSmallKeys<non_std::containers::ReplaceAlways>(0);
+    testReplacementSpreadsSmallKeys<non_std::containers::ReplaceTwoTier<Depth>>(1);
+    testKeySignatures();
+    testProbeDoesNotWrite();
+    testSaveAndOpenMapped();
+    testPagePolicy();
+    testUnmappedPages();
 
     std::cout << "fixed_size_hash_table_open_hashing_with_age passed" << std::endl;
 }
@@ -0,0 +1,91 @@
+#include "FlatHashMapTests.hpp"
+
+#include <non_std/containers/FlatHashMap.hpp>
+
+#include <cassert>
+#include <iostream>
+#include <stdint.h>
+#include <string>
+#include <utility>
+
+namespace test::flat_hash_map
+{
+
+using Map = non_std::containers::FlatHashMap<uint64_t, uint64_t, 4>;
+
+void testGetStoreAndOperator()
+{
+    Map map;
+    assert(map.get(1) == nullptr && "empty map shall not find anything");
+    *map[1] = 10;
+    map.store(2, 20);
+    assert(*map.get(1) == 10 && *map.get(2) == 20 && "map shall remember stored values");
+    *map[1] = 11;
+    map.store(2, 21);
+    assert(*map.get(1) == 11 && *map.get(2) == 21 && map.size() == 2 && "existing key shall be overwritten");
+}
+
+void testGrowth()
+{
+    Map map;
+    const uint64_t count = 100000;
+    for (uint64_t i = 0; i < count; ++i)
+    {
+        map.store(i << 20, i);
+    }
+    assert(map.size() == count && map.bucketCount() > count && "table shall grow with load factor");
+    for (uint64_t i = 0; i < count; ++i)
+    {
+        assert(*map.get(i << 20) == i && "keys shall be found after growing");
+    }
+    assert(map.get(count << 20) == nullptr && "missing key shall not be found");
+}
+
+struct ConstantHash
+{
+    uint64_t operator()(uint64_t) const { return 5; }
+};
+
+void testProbingAcrossGroups()
+{
+    // Every key has the same tag and home group, so lookups have to walk the probe sequence.
+    non_std::containers::FlatHashMap<uint64_t, uint64_t, 4, ConstantHash> map;
+    for (uint64_t i = 0; i < 200; ++i)
+    {
+        map.store(i, i * 2);
+    }
+    for (uint64_t i = 0; i < 200; ++i)
+    {
+        assert(*map.get(i) == i * 2 && "colliding keys shall be found");
+    }
+    assert(map.get(200) == nullptr && "missing colliding key shall not be found");
+}
+
+void testNonTrivialTypesClearAndMove()
+{
+    non_std::containers::FlatHashMap<std::string, std::string, 2> strings;
+    for (int i = 0; i < 1000; ++i)
+    {
+        *strings[std::to_string(i)] = std::string(40, 'a' + i % 26);
+    }
+    assert(*strings.get("25") == std::string(40, 'z') && "non trivial values shall survive rehash");
+
+    auto moved(std::move(strings));
+    assert(moved.size() == 1000 && *moved.get("0") == std::string(40, 'a') && "moved map shall keep its slots");
+    moved.clear();
+    assert(moved.size() == 0 && moved.get("0") == nullptr && "cleared map shall be empty");
+    moved.store("x", "y");
+    assert(*moved.get("x") == "y" && "cleared map shall be usable");
+}
+
+void test()
+{
+    testGetStoreAndOperator();
+    testGrowth();
+    testProbingAcrossGroups();
+    testNonTrivialTypesClearAndMove();
+
+    std::cout << "flat_hash_map passed" << std::endl;
+}
+
+}  // test::flat_hash_map
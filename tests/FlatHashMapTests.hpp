@@ -0,0 +1,8 @@
+#pragma once
+
+namespace test::flat_hash_map
+{
+
+void test();
+
+}  // test::flat_hash_map
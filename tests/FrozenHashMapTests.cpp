@@ -0,0 +1,112 @@
+#include "FrozenHashMapTests.hpp"
+
+#include <non_std/containers/FrozenHashMap.hpp>
+#include <non_std/containers/HashMap.hpp>
+
+#include <cassert>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <stdexcept>
+#include <stdint.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace test::frozen_hash_map
+{
+
+using Frozen = non_std::containers::FrozenHashMap<uint64_t, uint64_t>;
+
+void testFreezeFindsEveryKey()
+{
+    non_std::containers::HashMap<uint64_t, uint64_t, 4> map;
+    const uint64_t count = 20000;
+    for (uint64_t i = 0; i < count; ++i)
+    {
+        map.store(i << 20, i);
+    }
+    auto frozen = Frozen::freeze(map);
+    assert(frozen.size() == count && "frozen map shall hold every entry");
+    for (uint64_t i = 0; i < count; ++i)
+    {
+        assert(frozen.get(i << 20) != nullptr && *frozen.get(i << 20) == i && "every key shall be found");
+        assert(frozen.get((i << 20) + 1) == nullptr && "missing key shall not be found");
+    }
+}
+
+void testEmptyAndDuplicates()
+{
+    Frozen empty;
+    assert(empty.size() == 0 && empty.get(1) == nullptr && "empty frozen map shall not find anything");
+
+    std::vector<std::pair<uint64_t, uint64_t>> entries{{1, 1}, {2, 2}, {1, 3}};
+    bool thrown = false;
+    try
+    {
+        Frozen duplicated(entries);
+    }
+    catch (const std::invalid_argument&)
+    {
+        thrown = true;
+    }
+    assert(thrown && "duplicated keys shall be rejected");
+}
+
+void testMove()
+{
+    std::vector<std::pair<uint64_t, uint64_t>> entries{{1, 10}, {2, 20}, {3, 30}};
+    Frozen frozen(entries);
+    Frozen moved(std::move(frozen));
+    assert(*moved.get(2) == 20 && "moved map shall keep its entries");
+    assert(frozen.size() == 0 && frozen.get(2) == nullptr && "moved-from map shall find nothing");
+
+    Frozen assigned(std::vector<std::pair<uint64_t, uint64_t>>{{4, 40}});
+    assigned = std::move(moved);
+    assert(*assigned.get(3) == 30 && assigned.get(4) == nullptr && "move assigned map shall take the entries");
+    assert(moved.size() == 0 && moved.get(3) == nullptr && "move assigned-from map shall find nothing");
+}
+
+void testSaveAndOpen()
+{
+    std::vector<std::pair<uint64_t, uint64_t>> entries;
+    for (uint64_t i = 1; i <= 5000; ++i)
+    {
+        entries.emplace_back(i * 7919, i);
+    }
+    const auto path = (std::filesystem::temp_directory_path() / "non_std_frozen_hash_map_test.bin").string();
+    Frozen(entries).save(path);
+    {
+        auto opened = Frozen::open(path);
+        assert(opened.size() == entries.size() && "opened map shall hold every entry");
+        for (const auto& [key, val] : entries)
+        {
+            assert(*opened.get(key) == val && "opened map shall find every key");
+        }
+        assert(opened.get(7) == nullptr && "opened map shall not find missing key");
+    }
+
+    bool thrown = false;
+    try
+    {
+        non_std::containers::FrozenHashMap<uint32_t, uint64_t>::open(path);
+    }
+    catch (const std::runtime_error&)
+    {
+        thrown = true;
+    }
+    assert(thrown && "file built for other types shall be rejected");
+    std::remove(path.c_str());
+}
+
+void test()
+{
+    testFreezeFindsEveryKey();
+    testEmptyAndDuplicates();
+    testMove();
+    testSaveAndOpen();
+
+    std::cout << "frozen_hash_map passed" << std::endl;
+}
+
+}  // test::frozen_hash_map
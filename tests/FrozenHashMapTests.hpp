@@ -0,0 +1,8 @@
+#pragma once
+
+namespace test::frozen_hash_map
+{
+
+void test();
+
+}  // test::frozen_hash_map
@@ -0,0 +1,363 @@
+#include "HashMapTests.hpp"
+
+#include <non_std/containers/HashMap.hpp>
+
+#include <cassert>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <stdexcept>
+#include <stdint.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace test::hash_map
+{
+
+using Map = non_std::containers::HashMap<uint64_t, uint64_t, 4>;
+
+void testGetStoreAndOperator()
+{
+    Map map;
+    assert(map.get(1) == nullptr && "empty map shall not find anything");
+    *map[1] = 10;
+    map.store(2, 20);
+    assert(*map.get(1) == 10 && *map.get(2) == 20 && "map shall remember stored values");
+    *map[1] = 11;
+    assert(*map.get(1) == 11 && map.size() == 2 && "operator[] shall not duplicate existing key");
+    map.store(2, 21);
+    assert(*map.get(2) == 21 && "the newest stored value shall win");
+}
+
+void testIncrementalResize()
+{
+    Map map;
+    const uint64_t count = 100000;
+    bool sawResizing = false;
+    for (uint64_t i = 0; i < count; ++i)
+    {
+        // Keys sharing all low bits used to land in a single bucket.
+        *map[i << 20] = i;
+        sawResizing |= map.isResizing();
+        if (i % 997 == 0)
+        {
+            for (uint64_t j = 0; j <= i; j += 101)
+            {
+                assert(map.get(j << 20) != nullptr && *map.get(j << 20) == j && "keys shall be found while resizing");
+            }
+        }
+    }
+    assert(sawResizing && map.bucketCount() >= count && "table shall grow with load factor");
+    for (uint64_t i = 0; i < count; ++i)
+    {
+        assert(*map.get(i << 20) == i && "keys shall be found after resizing");
+    }
+    assert(map.get(count << 20) == nullptr && "missing key shall not be found");
+}
+
+void testNewestDuplicateSurvivesResize()
+{
+    Map map;
+    map.store(7, 1);
+    map.store(7, 2);
+    for (uint64_t i = 100; i < 1000; ++i)
+    {
+        map.store(i, i);
+    }
+    assert(*map.get(7) == 2 && "migration shall keep chain order");
+}
+
+struct StringLengthHash
+{
+    uint64_t operator()(const std::string& in) const { return in.size(); }
+};
+
+void testCustomHashAndKeys()
+{
+    non_std::containers::HashMap<int, std::string, 2> strings;
+    *strings["one"] = 1;
+    *strings["three"] = 3;
+    assert(*strings.get("one") == 1 && *strings.get("three") == 3 && strings.get("two") == nullptr
+        && "default hash shall work with non integer keys");
+
+    non_std::containers::HashMap<int, std::string, 2, StringLengthHash> lengths;
+    for (int i = 0; i < 100; ++i)
+    {
+        *lengths[std::to_string(i)] = i;
+    }
+    assert(*lengths.get("42") == 42 && *lengths.get("7") == 7 && "custom hash shall be used");
+}
+
+void testMove()
+{
+    Map map;
+    for (uint64_t i = 0; i < 1000; ++i)
+    {
+        map.store(i, i);
+    }
+    Map moved(std::move(map));
+    assert(*moved.get(999) == 999 && moved.size() == 1000 && "moved map shall keep its nodes");
+    Map assigned;
+    assigned = std::move(moved);
+    assert(*assigned.get(500) == 500 && "move assigned map shall keep its nodes");
+}
+
+void testPagePolicy()
+{
+    // 2^17 keys: the bucket table is mapped, large enough for the policy to apply.
+    Map map(non_std::internal::PagePolicy{true, true, 4});
+    for (uint64_t i = 0; i < (1u << 17); ++i)
+    {
+        map.store(i, i);
+    }
+    for (uint64_t i = 0; i < (1u << 17); ++i)
+    {
+        assert(*map.get(i) == i && "map with a page policy shall keep every key");
+    }
+    Map moved(std::move(map));
+    moved.store(1u << 20, 1);
+    assert(*moved.get(1u << 20) == 1 && moved.size() == (1u << 17) + 1 && "moved map shall keep its page policy");
+}
+
+void testUnmappedPages()
+{
+    // Leave dirty freed blocks of bucket table sizes behind, so operator new may hand them out again.
+    for (std::size_t bytes = 256 * 1024; bytes <= (std::size_t(4) << 20); bytes *= 2)
+    {
+        for (int round = 0; round < 2; ++round)
+        {
+            void* dirty = ::operator new(bytes, std::align_val_t(non_std::internal::PageSize));
+            std::memset(dirty, 0xff, bytes);
+            ::operator delete(dirty, std::align_val_t(non_std::internal::PageSize));
+        }
+    }
+    // The fallback path of platforms without mmap: bucket tables shall still start empty.
+    Map map(non_std::internal::PagePolicy{false, false, 1, false});
+    for (uint64_t i = 0; i < (1u << 17); i += 2)
+    {
+        map.store(i, i);
+    }
+    for (uint64_t i = 0; i < (1u << 17); ++i)
+    {
+        assert((i % 2 == 0 ? map.get(i) != nullptr && *map.get(i) == i : map.get(i) == nullptr)
+               && "unmapped bucket tables shall start empty");
+    }
+}
+
+void testEraseRecyclesNodes()
+{
+    Map map;
+    map.store(1, 10);
+    assert(map.erase(1) && map.get(1) == nullptr && map.size() == 0 && "erased key shall be gone");
+    assert(!map.erase(1) && "erasing missing key shall report it");
+
+    // Sliding window of 10k keys: erased nodes are reused, so the pool count stays put.
+    const uint64_t window = 10000;
+    for (uint64_t i = 0; i < window; ++i)
+    {
+        map.store(i, i);
+    }
+    const auto pools = map.allocatorStats().pools;
+    for (uint64_t i = window; i < window * 20; ++i)
+    {
+        map.store(i, i);
+        assert(map.erase(i - window) && "key inside the window shall be erased");
+    }
+    assert(map.size() == window && map.allocatorStats().pools == pools && "sliding key set shall run at steady memory");
+    assert(map.get(window * 19 - 1) == nullptr && *map.get(window * 19) == window * 19 && "only the window shall remain");
+}
+
+void testForEach()
+{
+    Map map;
+    for (uint64_t i = 0; i < 5000; ++i)
+    {
+        map.store(i, i * 3);
+    }
+    for (uint64_t i = 0; i < 5000; i += 2)
+    {
+        map.erase(i);
+    }
+    uint64_t count = 0;
+    uint64_t sum = 0;
+    map.forEach([&](const uint64_t& key, uint64_t& val)
+    {
+        assert(val == key * 3 && key % 2 == 1 && "forEach shall visit live entries only");
+        ++count;
+        sum += key;
+    });
+    assert(count == 2500 && sum == 2500ull * 2500 && "forEach shall visit every entry once");
+}
+
+void testGetBatch()
+{
+    Map map;
+    std::vector<uint64_t> keys;
+    for (uint64_t i = 0; i < 3000; ++i)
+    {
+        // Every third key is missing.
+        if (i % 3 != 0)
+        {
+            map.store(i << 20, i);
+        }
+        keys.push_back(i << 20);
+    }
+    std::vector<uint64_t*> out(keys.size());
+    for (auto key : keys)
+    {
+        map.prefetch(key);
+    }
+    map.getBatch(keys, out);
+    for (uint64_t i = 0; i < keys.size(); ++i)
+    {
+        assert(out[i] == map.get(keys[i]) && "getBatch shall agree with get");
+    }
+}
+
+struct NoCopy
+{
+    static inline int copies = 0;
+    uint64_t a;
+    uint64_t b;
+    NoCopy(uint64_t aIn, uint64_t bIn) : a(aIn), b(bIn) {}
+    NoCopy(const NoCopy& other) : a(other.a), b(other.b) { ++copies; }
+    NoCopy& operator=(const NoCopy& other) { a = other.a; b = other.b; ++copies; return *this; }
+    NoCopy(NoCopy&&) = default;
+    NoCopy& operator=(NoCopy&&) = default;
+};
+
+void testEmplace()
+{
+    non_std::containers::HashMap<NoCopy, uint64_t, 4> map;
+    auto [first, inserted] = map.tryEmplace(1, 10, 11);
+    assert(inserted && first->a == 10 && first->b == 11 && "tryEmplace shall construct from args");
+    auto [again, insertedAgain] = map.tryEmplace(1, 20, 21);
+    assert(!insertedAgain && again == first && again->a == 10 && "tryEmplace shall not touch existing key");
+    assert(!map.emplace(1, 30, 31).second && map.get(1)->a == 10 && "emplace shall not replace existing key");
+
+    auto [assigned, insertedByAssign] = map.insertOrAssign(1, NoCopy(40, 41));
+    assert(!insertedByAssign && assigned->a == 40 && "insertOrAssign shall assign existing key");
+    assert(map.insertOrAssign(2, NoCopy(50, 51)).second && map.get(2)->b == 51 && "insertOrAssign shall insert missing key");
+    for (uint64_t i = 3; i < 3000; ++i)
+    {
+        map.emplace(i, i, i);
+    }
+    assert(map.get(2999)->a == 2999 && NoCopy::copies == 0 && "values shall be constructed in place, never copied");
+}
+
+struct Counted
+{
+    static inline int alive = 0;
+    Counted() { ++alive; }
+    Counted(const Counted&) { ++alive; }
+    Counted& operator=(const Counted&) = default;
+    ~Counted() { --alive; }
+};
+
+void testNonTrivialValuesAreDestroyed()
+{
+    {
+        non_std::containers::HashMap<Counted, uint64_t, 2> map;
+        for (uint64_t i = 0; i < 1000; ++i)
+        {
+            map[i];
+        }
+        map.erase(0);
+        assert(Counted::alive == 999 && "erase shall destroy the value");
+        map.clear();
+        assert(Counted::alive == 0 && "clear shall destroy values");
+        map[1];
+    }
+    assert(Counted::alive == 0 && "destructor shall destroy values");
+}
+
+void testStoreBulk()
+{
+    Map map;
+    map.store(7, 70);
+    std::vector<std::pair<uint64_t, uint64_t>> entries;
+    for (uint64_t i = 0; i < 5000; ++i)
+    {
+        entries.emplace_back(i, i);
+    }
+    // Duplicates inside one batch: the later entry wins.
+    entries[10] = {3, 300};
+    entries[11] = {3, 301};
+    map.storeBulk(entries);
+    assert(map.size() == 4998 && "storeBulk shall store every distinct key once");
+    assert(*map.get(7) == 7 && "storeBulk shall assign keys already present");
+    assert(*map.get(3) == 301 && "storeBulk shall keep the last duplicate of a batch");
+    assert(map.bucketCount() > 16 && "storeBulk shall resize the table while inserting");
+    for (uint64_t i = 12; i < 5000; ++i)
+    {
+        assert(*map.get(i) == i && "storeBulk shall find every key after resizing");
+    }
+    assert(map.allocatorStats().liveObjects == map.size() && "storeBulk shall return unused nodes");
+}
+
+struct ThrowingCopy
+{
+    static inline int alive = 0;
+    static inline int copiesUntilThrow = -1;
+    uint64_t val = 0;
+    ThrowingCopy() { ++alive; }
+    ThrowingCopy(const ThrowingCopy& other)
+        : val(other.val)
+    {
+        if (copiesUntilThrow-- == 0)
+        {
+            throw std::runtime_error("copy");
+        }
+        ++alive;
+    }
+    ThrowingCopy& operator=(const ThrowingCopy&) = default;
+    ~ThrowingCopy() { --alive; }
+};
+
+void testStoreBulkThrowingCopy()
+{
+    {
+        non_std::containers::HashMap<ThrowingCopy, uint64_t, 4> map;
+        std::vector<std::pair<uint64_t, ThrowingCopy>> entries(100);
+        for (uint64_t i = 0; i < entries.size(); ++i)
+        {
+            entries[i].first = i;
+        }
+        ThrowingCopy::copiesUntilThrow = 40;
+        bool thrown = false;
+        try
+        {
+            map.storeBulk(entries);
+        }
+        catch (const std::runtime_error&)
+        {
+            thrown = true;
+        }
+        assert(thrown && map.size() == 40 && "storeBulk shall keep the entries stored before the throw");
+        assert(map.allocatorStats().liveObjects == 40 && "storeBulk shall give back unconstructed nodes");
+    }
+    assert(ThrowingCopy::alive == 0 && "map shall destroy only constructed values");
+}
+
+void test()
+{
+    testGetStoreAndOperator();
+    testIncrementalResize();
+    testNewestDuplicateSurvivesResize();
+    testCustomHashAndKeys();
+    testMove();
+    testPagePolicy();
+    testUnmappedPages();
+    testEraseRecyclesNodes();
+    testForEach();
+    testGetBatch();
+    testEmplace();
+    testNonTrivialValuesAreDestroyed();
+    testStoreBulk();
+    testStoreBulkThrowingCopy();
+
+    std::cout << "hash_map passed" << std::endl;
+}
+
+}  // test::hash_map
@@ -0,0 +1,8 @@
+#pragma once
+
+namespace test::hash_map
+{
+
+void test();
+
+}  // test::hash_map
@@ -0,0 +1,86 @@
+#include "LruCacheTests.hpp"
+
+#include <non_std/containers/LruCache.hpp>
+
+#include <cassert>
+#include <iostream>
+#include <stdint.h>
+#include <string>
+
+namespace test::lru_cache
+{
+
+using Cache = non_std::containers::LruCache<uint64_t, uint64_t>;
+
+void testEvictsLeastRecentlyUsed()
+{
+    Cache cache(3);
+    cache.store(1, 10);
+    cache.store(2, 20);
+    cache.store(3, 30);
+    cache.store(4, 40);
+    assert(cache.size() == 3 && cache.get(1) == nullptr && "oldest entry shall be evicted when full");
+    assert(*cache.get(2) == 20 && *cache.get(3) == 30 && *cache.get(4) == 40 && "newer entries shall stay");
+}
+
+void testAccessRefreshesRecency()
+{
+    Cache cache(3);
+    cache.store(1, 10);
+    cache.store(2, 20);
+    cache.store(3, 30);
+    cache.get(1);
+    cache.store(4, 40);
+    assert(cache.get(2) == nullptr && *cache.get(1) == 10 && "get shall protect an entry from eviction");
+
+    *cache[3] = 31;
+    cache.store(4, 41);
+    cache.store(5, 50);
+    assert(cache.get(1) == nullptr && *cache.get(3) == 31 && *cache.get(4) == 41 && "operator[] and store shall refresh");
+
+    assert(cache.erase(3) && !cache.erase(3) && cache.size() == 2 && "erase shall remove the entry once");
+    cache.store(6, 60);
+    assert(cache.size() == 3 && cache.get(4) != nullptr && cache.get(5) != nullptr && "erased entry shall free its place");
+}
+
+void testChurnDoesNotAllocate()
+{
+    Cache cache(1000);
+    for (uint64_t i = 0; i < 1000; ++i)
+    {
+        cache.store(i, i);
+    }
+    const auto pools = cache.allocatorStats().pools;
+    for (uint64_t i = 1000; i < 100000; ++i)
+    {
+        cache.store(i, i);
+        assert(cache.size() == 1000 && "size shall stay at capacity");
+    }
+    assert(cache.allocatorStats().pools == pools && "evicted nodes shall be reused");
+    assert(*cache.get(99999) == 99999 && cache.get(98999) == nullptr && "only the last keys shall stay");
+}
+
+void testNonTrivialValues()
+{
+    non_std::containers::LruCache<std::string, std::string> cache(2);
+    cache.store("a", std::string(40, 'a'));
+    cache.tryEmplace("b", 40, 'b');
+    cache.store("c", std::string(40, 'c'));
+    assert(cache.get("a") == nullptr && *cache.get("b") == std::string(40, 'b') && "strings shall be evicted too");
+    cache.clear();
+    assert(cache.size() == 0 && cache.get("c") == nullptr && "cleared cache shall be empty");
+    cache.store("d", "x");
+    assert(*cache.get("d") == "x" && "cleared cache shall be usable");
+}
+
+void test()
+{
+    testEvictsLeastRecentlyUsed();
+    testAccessRefreshesRecency();
+    testChurnDoesNotAllocate();
+    testNonTrivialValues();
+
+    std::cout << "lru_cache passed" << std::endl;
+}
+
+}  // test::lru_cache
@@ -0,0 +1,8 @@
+#pragma once
+
+namespace test::lru_cache
+{
+
+void test();
+
+}  // test::lru_cache
@@ -0,0 +1,74 @@
+#include "MonotonicArenaTests.hpp"
+
+#include <non_std/MonotonicArena.hpp>
+
+#include <cassert>
+#include <cstring>
+#include <iostream>
+#include <stdint.h>
+
+namespace test::monotonic_arena
+{
+
+void testAllocationsAreAlignedAndDisjoint()
+{
+    MonotonicArena arena(1024);
+    unsigned char* previousEnd = nullptr;
+    for (std::size_t i = 1; i < 200; ++i)
+    {
+        auto alignment = std::size_t(1) << (i % 7);
+        auto* ptr = static_cast<unsigned char*>(arena.allocate(i, alignment));
+        assert(reinterpret_cast<uintptr_t>(ptr) % alignment == 0 && "allocation shall respect alignment");
+        std::memset(ptr, 0xab, i);
+        assert((previousEnd == nullptr || ptr >= previousEnd || ptr + i <= previousEnd - (i - 1))
+            && "allocations shall not overlap");
+        previousEnd = ptr + i;
+    }
+    auto* big = arena.allocate<uint64_t>(4096);
+    big[4095] = 1;
+}
+
+void testRewind()
+{
+    MonotonicArena arena(256);
+    auto* first = arena.allocate<uint64_t>();
+    auto checkpoint = arena.checkpoint();
+    auto* second = arena.allocate<uint64_t>();
+    for (int i = 0; i < 100; ++i)
+    {
+        arena.allocate<uint64_t>(8);
+    }
+    const auto reserved = arena.bytesReserved();
+
+    arena.rewind(checkpoint);
+    assert(arena.allocate<uint64_t>() == second && "rewind shall free everything after the checkpoint");
+    for (int i = 0; i < 100; ++i)
+    {
+        arena.allocate<uint64_t>(8);
+    }
+    assert(arena.bytesReserved() == reserved && "chunks shall be reused after rewind");
+
+    arena.reset();
+    assert(arena.allocate<uint64_t>() == first && "reset shall free everything");
+    arena.releaseUnusedChunks();
+    assert(arena.bytesReserved() == 256 && "unused chunks shall be released");
+}
+
+void testHugePages()
+{
+    MonotonicArena arena(1, true);
+    auto* ptr = arena.allocate<uint64_t>(1000);
+    ptr[999] = 7;
+    assert(arena.bytesReserved() == non_std::internal::HugePageSize && "huge page chunks shall be huge page multiples");
+}
+
+void test()
+{
+    testAllocationsAreAlignedAndDisjoint();
+    testRewind();
+    testHugePages();
+
+    std::cout << "monotonic_arena passed" << std::endl;
+}
+
+}  // test::monotonic_arena
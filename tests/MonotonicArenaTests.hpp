@@ -0,0 +1,8 @@
+#pragma once
+
+namespace test::monotonic_arena
+{
+
+void test();
+
+}  // test::monotonic_arena
@@ -0,0 +1,295 @@
+#include "PoolAllocatorTests.hpp"
+
+#include <non_std/PoolAlocator.hpp>
+#include <non_std/PoolMemoryResource.hpp>
+
+#include <cassert>
+#include <iostream>
+#include <list>
+#include <map>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <stdint.h>
+#include <vector>
+
+namespace test::pool_allocator
+{
+
+constexpr int NodesPerPool = PoolAllocator<uint64_t>::NodesPerPool;
+
+void testAllocatedSlotsAreUnique()
+{
+    PoolAllocator<uint64_t> allocator;
+    std::set<uint64_t*> seen;
+    for (int i = 0; i < 3 * NodesPerPool + 17; ++i)
+    {
+        auto* ptr = allocator.allocate();
+        assert(seen.insert(ptr).second && "allocator shall never hand out the same slot twice");
+        *ptr = i;
+    }
+}
+
+void testFreedSlotIsReused()
+{
+    PoolAllocator<uint64_t> allocator;
+    std::vector<uint64_t*> ptrs;
+    for (int i = 0; i < 2 * NodesPerPool; ++i)
+    {
+        ptrs.push_back(allocator.allocate());
+    }
+    // Free a slot from the first (full) pool, which is not the head of the full list.
+    auto* freed = ptrs[5];
+    allocator.dealocate(freed);
+    assert(allocator.allocate() == freed && "freed slot from full pool shall be reused first");
+
+    for (auto i = 0u; i < ptrs.size(); i += 2)
+    {
+        allocator.dealocate(ptrs[i]);
+    }
+    std::set<uint64_t*> reused;
+    for (auto i = 0u; i < ptrs.size(); i += 2)
+    {
+        reused.insert(allocator.allocate());
+    }
+    for (auto i = 0u; i < ptrs.size(); i += 2)
+    {
+        assert(reused.count(ptrs[i]) == 1 && "all freed slots shall be reused before a new pool is created");
+    }
+}
+
+struct alignas(32) OverAligned
+{
+    unsigned char payload[40];
+};
+
+void testNodesAreAlignedAndTightlyPacked()
+{
+    PoolAllocator<OverAligned> allocator;
+    auto* first = allocator.allocate();
+    auto* second = allocator.allocate();
+    assert(reinterpret_cast<uintptr_t>(first) % alignof(OverAligned) == 0 && "node shall respect alignof(T)");
+    assert(reinterpret_cast<unsigned char*>(second) - reinterpret_cast<unsigned char*>(first) == sizeof(OverAligned)
+        && "node stride shall be exactly sizeof(T)");
+    allocator.dealocate(first);
+    assert(allocator.allocate() == first && "pool shall be found from the node address");
+}
+
+void testClearAll()
+{
+    PoolAllocator<uint64_t> allocator;
+    std::set<uint64_t*> first;
+    for (int i = 0; i < 2 * NodesPerPool; ++i)
+    {
+        first.insert(allocator.allocate());
+    }
+    allocator.clearAll();
+    for (int i = 0; i < 2 * NodesPerPool; ++i)
+    {
+        assert(first.count(allocator.allocate()) == 1 && "clearAll shall make all slots available again");
+    }
+}
+
+void testStatsAndTrimPolicy()
+{
+    PoolAllocatorTrimPolicy policy;
+    policy.highWaterMark = 2;
+    policy.lowWaterMark = 1;
+    PoolAllocator<uint64_t> allocator(policy);
+
+    std::vector<uint64_t*> ptrs;
+    for (int i = 0; i < 4 * NodesPerPool; ++i)
+    {
+        ptrs.push_back(allocator.allocate());
+    }
+    auto stats = allocator.stats();
+    assert(stats.liveObjects == 4u * NodesPerPool && "stats shall count live objects");
+    assert(stats.pools == 4 && "stats shall count pools");
+    assert(stats.bytesReserved == 4 * PoolAllocator<uint64_t>::PoolSize && "stats shall count reserved bytes");
+    assert(stats.bytesInUse == 4u * NodesPerPool * sizeof(uint64_t) && "stats shall count used bytes");
+
+    // Free pools one by one: the third free pool crosses the high-water mark and trims down to one.
+    for (int pool = 0; pool < 3; ++pool)
+    {
+        for (int i = 0; i < NodesPerPool; ++i)
+        {
+            allocator.dealocate(ptrs[pool * NodesPerPool + i]);
+        }
+        assert(allocator.stats().pools == (pool < 2 ? 4u : 2u) && "free pools shall be kept until high-water mark");
+    }
+    assert(allocator.stats().liveObjects == std::size_t(NodesPerPool) && "stats shall follow deallocations");
+
+    allocator.clearAll();
+    assert(allocator.stats().liveObjects == 0 && allocator.stats().pools == 2 && "clearAll shall not trim below high-water mark");
+    allocator.releaseEmptyPools();
+    assert(allocator.stats().pools == 0 && allocator.stats().bytesReserved == 0 && "all free pools shall be released");
+    assert(allocator.allocate() != nullptr && "allocator shall recover after releasing every pool");
+}
+
+void testHugePageSlabs()
+{
+    // Enough pools for several huge page chunks; the pattern shall survive chunk boundaries.
+    constexpr int Nodes = 4 * (PoolAllocator<uint64_t>::MaxChunkSize / PoolAllocator<uint64_t>::PoolSize) * NodesPerPool;
+    PoolAllocator<uint64_t> allocator(PoolAllocatorTrimPolicy{}, non_std::internal::PagePolicy{true, true});
+    std::vector<uint64_t*> ptrs;
+    for (int i = 0; i < Nodes; ++i)
+    {
+        ptrs.push_back(allocator.allocate());
+        *ptrs.back() = i;
+    }
+    std::set<uint64_t*> unique(ptrs.begin(), ptrs.end());
+    assert(unique.size() == ptrs.size() && "huge page slabs shall not overlap");
+    for (int i = 0; i < Nodes; ++i)
+    {
+        assert(*ptrs[i] == uint64_t(i) && "huge page slabs shall keep values");
+    }
+    for (auto* ptr : ptrs)
+    {
+        allocator.dealocate(ptr);
+    }
+    allocator.releaseEmptyPools();
+    assert(allocator.stats().pools == 0 && allocator.stats().bytesMapped == 0 && "huge page slabs shall be released");
+    assert(allocator.allocate() != nullptr && "allocator shall map a new chunk after releasing every chunk");
+}
+
+void testTrimCyclesReuseChunks()
+{
+    // Every cycle keeps one node of every fourth pool alive and trims the rest, so chunks keep
+    // holes; the next cycle shall fill those holes instead of mapping new chunks.
+    constexpr int Nodes = 512 * NodesPerPool;
+    PoolAllocator<uint64_t> allocator;
+    std::vector<uint64_t*> kept;
+    std::size_t firstPeak = 0;
+    for (int cycle = 0; cycle < 8; ++cycle)
+    {
+        std::vector<uint64_t*> batch;
+        for (int i = 0; i < Nodes; ++i)
+        {
+            batch.push_back(allocator.allocate());
+        }
+        const auto peak = allocator.stats().bytesMapped;
+        firstPeak = cycle == 0 ? peak : firstPeak;
+        assert(peak <= 2 * firstPeak && "repeated trim cycles shall not keep mapping new chunks");
+        for (auto* ptr : kept)
+        {
+            allocator.dealocate(ptr);
+        }
+        kept.clear();
+        for (int i = 0; i < Nodes; ++i)
+        {
+            if (i % (4 * NodesPerPool) == 0)
+            {
+                kept.push_back(batch[i]);
+            }
+            else
+            {
+                allocator.dealocate(batch[i]);
+            }
+        }
+        allocator.releaseEmptyPools();
+        assert(allocator.stats().bytesMapped <= peak && "trimming shall not map memory");
+    }
+    for (auto* ptr : kept)
+    {
+        allocator.dealocate(ptr);
+    }
+    allocator.releaseEmptyPools();
+    assert(allocator.stats().bytesMapped == 0 && "releasing every pool shall release every chunk");
+}
+
+void testBulkAllocation()
+{
+    PoolAllocator<uint64_t> allocator;
+    auto* single = allocator.allocate();
+
+    const std::size_t count = 3 * NodesPerPool + 5;
+    std::vector<uint64_t*> ptrs(count);
+    allocator.allocateBulk(count, ptrs.data());
+    std::set<uint64_t*> unique(ptrs.begin(), ptrs.end());
+    assert(unique.size() == count && unique.count(single) == 0 && "bulk allocation shall hand out distinct free slots");
+    assert(allocator.stats().liveObjects == count + 1 && "bulk allocation shall be counted");
+
+    const auto pools = allocator.stats().pools;
+    allocator.dealocateBulk(ptrs);
+    assert(allocator.stats().liveObjects == 1 && "bulk deallocation shall be counted");
+
+    std::vector<uint64_t*> again(count);
+    allocator.allocateBulk(count, again.data());
+    assert(allocator.stats().pools == pools && "bulk freed slots shall be reused");
+    assert(std::set<uint64_t*>(again.begin(), again.end()).size() == count && "reused slots shall be distinct");
+}
+
+void testForEachAllocated()
+{
+    PoolAllocator<uint64_t> allocator;
+    std::set<uint64_t*> live;
+    for (int i = 0; i < 3 * NodesPerPool; ++i)
+    {
+        live.insert(allocator.allocate());
+    }
+    for (auto it = live.begin(); it != live.end();)
+    {
+        allocator.dealocate(*it);
+        it = live.erase(it);
+        if (it != live.end())
+        {
+            ++it;
+        }
+    }
+    std::set<uint64_t*> visited;
+    allocator.forEachAllocated([&visited](uint64_t* node) { visited.insert(node); });
+    assert(visited == live && "forEachAllocated shall visit exactly the allocated nodes");
+}
+
+void testStdAllocatorAdapter()
+{
+    PoolMemoryResource resource;
+    {
+        using Allocator = PoolStdAllocator<std::pair<const int, int>>;
+        std::map<int, int, std::less<int>, Allocator> map{Allocator(&resource)};
+        std::unordered_map<int, int, std::hash<int>, std::equal_to<int>, Allocator> hashMap{16, std::hash<int>(),
+            std::equal_to<int>(), Allocator(&resource)};
+        for (int i = 0; i < 1000; ++i)
+        {
+            map[i] = i;
+            hashMap[i] = i;
+        }
+        assert(resource.stats().liveObjects == 2000 && "map and unordered_map nodes shall come from the pools");
+        for (int i = 0; i < 1000; i += 2)
+        {
+            map.erase(i);
+            hashMap.erase(i);
+        }
+        assert(resource.stats().liveObjects == 1000 && "erased nodes shall go back to the pools");
+        assert(map.size() == 500 && map.begin()->second == 1 && hashMap.at(999) == 999 && "containers shall work");
+    }
+    assert(resource.stats().liveObjects == 0 && "destroyed containers shall release every node");
+
+    {
+        std::pmr::list<std::pmr::string> list(&resource);
+        list.emplace_back(300, 'x');
+        list.emplace_back("short");
+        assert(list.front().size() == 300 && list.back() == "short" && "pmr containers shall work");
+        assert(resource.stats().liveObjects == 2 && "large string buffer shall go upstream, list nodes to the pools");
+    }
+    resource.releaseEmptyPools();
+    assert(resource.stats().bytesReserved == 0 && "pools shall be released");
+}
+
+void test()
+{
+    testAllocatedSlotsAreUnique();
+    testFreedSlotIsReused();
+    testNodesAreAlignedAndTightlyPacked();
+    testClearAll();
+    testStatsAndTrimPolicy();
+    testHugePageSlabs();
+    testTrimCyclesReuseChunks();
+    testBulkAllocation();
+    testForEachAllocated();
+    testStdAllocatorAdapter();
+
+    std::cout << "pool_allocator passed" << std::endl;
+}
+
+}  // test::pool_allocator
@@ -0,0 +1,8 @@
+#pragma once
+
+namespace test::pool_allocator
+{
+
+void test();
+
+}  // test::pool_allocator
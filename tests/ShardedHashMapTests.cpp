@@ -0,0 +1,110 @@
+#include "ShardedHashMapTests.hpp"
+
+#include <non_std/containers/threadSafe/ShardedHashMap.hpp>
+
+#include <atomic>
+#include <cassert>
+#include <functional>
+#include <iostream>
+#include <stdint.h>
+#include <thread>
+#include <vector>
+
+namespace test::sharded_hash_map
+{
+
+using Map = non_std::containers::thread_safe::ShardedHashMap<uint64_t, uint64_t>;
+
+void testSingleThreaded()
+{
+    Map map;
+    assert(!map.get(1) && "empty map shall not find anything");
+    map.store(1, 10);
+    map.store(1, 11);
+    assert(*map.get(1) == 11 && map.size() == 1 && "store shall overwrite");
+    assert(map.erase(1) && !map.get(1) && !map.erase(1) && "erase shall remove the key");
+}
+
+void testSequentialKeysSpreadOverShards()
+{
+    // std::hash of an integer is the identity with libstdc++: small keys have no top bits.
+    using IdentityMap = non_std::containers::thread_safe::ShardedHashMap<uint64_t, uint64_t, 6, std::hash<uint64_t>>;
+    IdentityMap map;
+    std::vector<std::size_t> perShard(IdentityMap::Shards);
+    for (uint64_t key = 0; key < 64 * IdentityMap::Shards; ++key)
+    {
+        ++perShard[map.shardIndex(key)];
+    }
+    for (auto count : perShard)
+    {
+        assert(count > 0 && count < 4 * 64 && "sequential keys shall spread over every shard");
+    }
+}
+
+void testConcurrentReadersAndWriters()
+{
+    constexpr uint64_t Writers = 4;
+    constexpr uint64_t PerWriter = 20000;
+    Map map;
+    std::atomic<bool> done = false;
+    std::vector<std::thread> threads;
+    for (uint64_t t = 0; t < Writers; ++t)
+    {
+        threads.emplace_back([t, &map]() {
+            for (uint64_t i = 0; i < PerWriter; ++i)
+            {
+                // Every key is written twice and every odd key erased, while readers look.
+                uint64_t key = t * PerWriter + i;
+                map.store(key, key);
+                map.store(key, key + 1);
+                if (key % 2 == 1)
+                {
+                    map.erase(key);
+                }
+            }
+        });
+    }
+    for (int r = 0; r < 2; ++r)
+    {
+        threads.emplace_back([&map, &done]() {
+            while (!done.load())
+            {
+                for (uint64_t key = 0; key < Writers * PerWriter; key += 7)
+                {
+                    auto val = map.get(key);
+                    assert((!val || *val == key || *val == key + 1) && "reader shall see a stored value or nothing");
+                }
+            }
+        });
+    }
+    for (uint64_t t = 0; t < Writers; ++t)
+    {
+        threads[t].join();
+    }
+    done = true;
+    for (auto& thread : threads)
+    {
+        if (thread.joinable())
+        {
+            thread.join();
+        }
+    }
+
+    assert(map.size() == Writers * PerWriter / 2 && "every even key shall remain");
+    for (uint64_t key = 0; key < Writers * PerWriter; ++key)
+    {
+        auto val = map.get(key);
+        assert((key % 2 == 1 ? !val : *val == key + 1) && "final content shall match the writes");
+    }
+}
+
+void test()
+{
+    testSingleThreaded();
+    testSequentialKeysSpreadOverShards();
+    testConcurrentReadersAndWriters();
+
+    std::cout << "sharded_hash_map passed" << std::endl;
+}
+
+}  // test::sharded_hash_map
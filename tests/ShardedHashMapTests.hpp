@@ -0,0 +1,8 @@
+#pragma once
+
+namespace test::sharded_hash_map
+{
+
+void test();
+
+}  // test::sharded_hash_map
@@ -0,0 +1,98 @@
+#include "SharedHashTableWithAgeTests.hpp"
+
+#include <non_std/containers/threadSafe/lockFree/SharedHashTableWithAge.hpp>
+
+#include <atomic>
+#include <cassert>
+#include <iostream>
+#include <stdint.h>
+#include <thread>
+#include <vector>
+
+namespace test::shared_hash_table_with_age
+{
+
+struct PassTrhoughtHash
+{
+    uint64_t operator()(uint64_t in) const {return in;}
+};
+
+// Two words which only match each other when written by one store.
+struct Entry
+{
+    uint64_t key;
+    uint64_t tripled;
+};
+
+using Table = non_std::containers::thread_safe::lock_free::SharedHashTableWithAge<uint64_t, Entry, PassTrhoughtHash>;
+
+void testSingleThreaded()
+{
+    Table table(1000);
+    assert(table.capacity() == 1024 && "size shall be rounded up to a power of two");
+    assert(!table.get(1) && "empty table shall not find anything");
+    table.store(1, Entry{1, 3});
+    table.store(0, Entry{0, 0});
+    assert(table.get(1)->tripled == 3 && table.get(0) && "table shall remember stored values");
+    table.store(1, Entry{1, 4});
+    assert(table.get(1)->tripled == 4 && "store shall overwrite");
+    table.clear();
+    assert(!table.get(1) && !table.get(0) && "clear shall forget every key");
+}
+
+void testOldGenerationIsReplaced()
+{
+    Table table(64);
+    uint64_t key = 5;
+    for (unsigned int i = 0; i < Table::HashTries; ++i)
+    {
+        table.store(key + i * 64, Entry{key, 0});
+        table.newGeneration();
+    }
+    table.store(key + Table::HashTries * 64, Entry{key, 1});
+    assert(!table.get(key) && "the oldest generation shall be replaced");
+    assert(table.get(key + 64) && table.get(key + Table::HashTries * 64) && "younger entries shall stay");
+}
+
+void testConcurrentWritersNeverTearEntries()
+{
+    constexpr uint64_t Threads = 4;
+    constexpr uint64_t Keys = 256;
+    Table table(128);
+    std::atomic<uint64_t> mismatches = 0;
+    std::vector<std::thread> threads;
+    for (uint64_t t = 0; t < Threads; ++t)
+    {
+        threads.emplace_back([t, &table, &mismatches]() {
+            for (uint64_t i = 0; i < 200000; ++i)
+            {
+                uint64_t key = (i * 31 + t) % Keys;
+                uint64_t val = i * Threads + t;
+                if (i % 2 == 0)
+                {
+                    table.store(key, Entry{val, val * 3});
+                }
+                else if (auto entry = table.get(key); entry && entry->tripled != entry->key * 3)
+                {
+                    ++mismatches;
+                }
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    assert(mismatches == 0 && "a reader shall never see words of two different stores");
+}
+
+void test()
+{
+    testSingleThreaded();
+    testOldGenerationIsReplaced();
+    testConcurrentWritersNeverTearEntries();
+
+    std::cout << "shared_hash_table_with_age passed" << std::endl;
+}
+
+}  // test::shared_hash_table_with_age
@@ -0,0 +1,8 @@
+#pragma once
+
+namespace test::shared_hash_table_with_age
+{
+
+void test();
+
+}  // test::shared_hash_table_with_age